@@ -0,0 +1,163 @@
+/**
+  C++ Multithreaded Periodic Task Scheduler
+
+  Affinity.cpp
+
+  Purpose:
+  Function implementations for reading the NUMA topology and pinning threads
+
+  @version 1.0 10/18/2026
+*/
+#if !defined(_WIN32) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE		// cpu_set_t and sched_setaffinity
+#endif
+#include <iostream>
+#include <algorithm>
+#include "Affinity.h"
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <sched.h>
+#ifdef HAVE_LIBNUMA
+#include <numa.h>
+#endif
+#endif
+
+// Returns true if any node has a CPU the process may run on
+static bool has_cpus(const std::vector<std::vector<int>> &nodes)
+{
+	return std::any_of(nodes.begin(), nodes.end(), [](const std::vector<int> &cpus) { return !cpus.empty(); });
+}
+
+#ifdef _WIN32
+
+// Function to get the CPUs of each NUMA node
+std::vector<std::vector<int>> get_numa_nodes()
+{
+	std::vector<std::vector<int>> nodes;
+	ULONG highest = 0;
+	DWORD_PTR process_mask = 0, system_mask = 0;
+
+	GetProcessAffinityMask(GetCurrentProcess(), &process_mask, &system_mask);
+
+	if (GetNumaHighestNodeNumber(&highest))
+	{
+		for (ULONG node = 0; node <= highest; node++)
+		{
+			// A node that can't be read keeps its slot without CPUs
+			ULONGLONG mask = 0;
+			std::vector<int> cpus;
+			if (GetNumaNodeProcessorMask((UCHAR)node, &mask))
+			{
+				// Only CPUs the process may run on
+				mask &= (ULONGLONG)process_mask;
+				for (int cpu = 0; cpu < 64; cpu++)
+				{
+					if (mask & (1ULL << cpu))
+						cpus.push_back(cpu);
+				}
+			}
+			nodes.push_back(cpus);
+		}
+	}
+
+	if (!has_cpus(nodes))
+	{
+		// No NUMA information, every CPU of the process is on one node
+		std::vector<int> cpus;
+		for (int cpu = 0; cpu < (int)sizeof(DWORD_PTR) * 8; cpu++)
+		{
+			if (process_mask & ((DWORD_PTR)1 << cpu))
+				cpus.push_back(cpu);
+		}
+		nodes.assign(1, cpus);
+	}
+	return nodes;
+}
+
+// Function to restrict the calling thread to a set of CPUs
+int pin_current_thread(const std::vector<int> &cpus)
+{
+	DWORD_PTR mask = 0;
+
+	for (int cpu : cpus)
+	{
+		if (cpu < (int)sizeof(DWORD_PTR) * 8)
+			mask |= (DWORD_PTR)1 << cpu;
+	}
+	if (!mask || !SetThreadAffinityMask(GetCurrentThread(), mask))
+	{
+		fprintf(stderr, "Unable to set thread affinity (%lu)\n", GetLastError());
+		return 0;
+	}
+	return 1;
+}
+
+#else
+
+// Function to get the CPUs of each NUMA node
+std::vector<std::vector<int>> get_numa_nodes()
+{
+	std::vector<std::vector<int>> nodes;
+	cpu_set_t allowed;
+
+	CPU_ZERO(&allowed);
+	sched_getaffinity(0, sizeof(allowed), &allowed);
+
+#ifdef HAVE_LIBNUMA
+	if (numa_available() >= 0)
+	{
+		struct bitmask *node_cpus = numa_allocate_cpumask();
+		for (int node = 0; node <= numa_max_node(); node++)
+		{
+			// A node that can't be read keeps its slot without CPUs
+			std::vector<int> cpus;
+			if (numa_node_to_cpus(node, node_cpus) >= 0)
+			{
+				for (unsigned cpu = 0; cpu < node_cpus->size && cpu < CPU_SETSIZE; cpu++)
+				{
+					// Only CPUs the process may run on
+					if (numa_bitmask_isbitset(node_cpus, cpu) && CPU_ISSET(cpu, &allowed))
+						cpus.push_back((int)cpu);
+				}
+			}
+			nodes.push_back(cpus);
+		}
+		numa_free_cpumask(node_cpus);
+	}
+#endif
+
+	if (!has_cpus(nodes))
+	{
+		// No NUMA information, every CPU of the process is on one node
+		std::vector<int> cpus;
+		for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+		{
+			if (CPU_ISSET(cpu, &allowed))
+				cpus.push_back(cpu);
+		}
+		nodes.assign(1, cpus);
+	}
+	return nodes;
+}
+
+// Function to restrict the calling thread to a set of CPUs, pid 0 makes sched_setaffinity apply to the calling thread only
+int pin_current_thread(const std::vector<int> &cpus)
+{
+	cpu_set_t set;
+
+	CPU_ZERO(&set);
+	for (int cpu : cpus)
+	{
+		if (cpu >= 0 && cpu < CPU_SETSIZE)
+			CPU_SET(cpu, &set);
+	}
+	if (!CPU_COUNT(&set) || sched_setaffinity(0, sizeof(set), &set))
+	{
+		fprintf(stderr, "Unable to set thread affinity\n");
+		return 0;
+	}
+	return 1;
+}
+
+#endif
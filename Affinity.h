@@ -0,0 +1,46 @@
+/**
+  C++ Multithreaded Periodic Task Scheduler
+
+  Affinity.h
+
+  Purpose:
+  Header file for functions to read the NUMA topology and pin threads to CPUs
+
+  Build with HAVE_LIBNUMA defined (and link libnuma) to read the NUMA nodes
+  on Linux, otherwise all CPUs the process may run on form a single node.
+
+  @version 1.0 10/18/2026
+*/
+#pragma once
+#include <vector>
+
+/**
+	Placement of scheduler workers on CPUs
+
+	AFFINITY_NONE Workers float across all CPUs and task node hints are ignored
+	AFFINITY_NODE Workers are grouped by NUMA node and bound to the CPUs of their node
+	AFFINITY_CPU Workers are grouped by NUMA node and each bound to a single CPU of their node
+*/
+enum AffinityMode
+{
+	AFFINITY_NONE,
+	AFFINITY_NODE,
+	AFFINITY_CPU
+};
+
+/**
+  Function to get the CPUs of each NUMA node
+
+  @return CPU numbers of each node, indexed by node number. Nodes without CPUs the
+	process may run on, or whose CPUs can't be read, are left empty. A single node
+	holding every CPU the process may run on if NUMA information is unavailable.
+*/
+std::vector<std::vector<int>> get_numa_nodes();
+
+/**
+  Function to restrict the calling thread to a set of CPUs
+
+  @param cpus CPU numbers the thread may run on
+  @return returns 1 if successfull else 0
+*/
+int pin_current_thread(const std::vector<int> &cpus);
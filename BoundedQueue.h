@@ -0,0 +1,128 @@
+/**
+  C++ Multithreaded Periodic Task Scheduler
+
+  BoundedQueue.h
+
+  Purpose:
+  Header file for BoundedQueue, a blocking FIFO queue of limited capacity
+
+  @version 1.0 10/18/2026
+*/
+#pragma once
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+
+/**
+	BoundedQueue
+
+	@member items Queued items
+	@member capacity Maximum number of queued items
+	@member queue_mutex Mutex to lock while reading or writing to the queue
+	@member not_empty Condition Variable to notify consumers when an item is pushed
+	@member not_full Condition Variable to notify producers when an item is popped
+	@member closed Bool value set once no more items are accepted
+*/
+template <typename T>
+class BoundedQueue
+{
+private:
+	std::deque<T> items;
+	std::size_t capacity;
+	std::mutex queue_mutex;
+	std::condition_variable not_empty;
+	std::condition_variable not_full;
+	bool closed = false;
+
+public:
+	/**
+	  BoundedQueue Constructor
+
+	  @param c Maximum number of queued items
+	*/
+	BoundedQueue(std::size_t c)
+		:capacity(c)
+	{}
+
+	/**
+	  Pushes an item, waiting while the queue is full
+
+	  @param item Item to push
+	  @return false if the queue was closed
+	*/
+	bool push(const T &item)
+	{
+		{
+			std::unique_lock<std::mutex> lock(queue_mutex);
+			while (items.size() >= capacity && !closed)
+				not_full.wait(lock);
+			if (closed)
+				return false;
+			items.push_back(item);
+		}
+		not_empty.notify_one();
+		return true;
+	}
+
+	/**
+	  Pushes an item unless the queue is full
+
+	  @param item Item to push
+	  @return false if the queue was full or closed
+	*/
+	bool try_push(const T &item)
+	{
+		{
+			std::unique_lock<std::mutex> lock(queue_mutex);
+			if (items.size() >= capacity || closed)
+				return false;
+			items.push_back(item);
+		}
+		not_empty.notify_one();
+		return true;
+	}
+
+	/**
+	  Pops the oldest item, waiting while the queue is empty
+
+	  @param item Popped item
+	  @return false if the queue was closed and is empty
+	*/
+	bool pop(T &item)
+	{
+		{
+			std::unique_lock<std::mutex> lock(queue_mutex);
+			while (items.empty() && !closed)
+				not_empty.wait(lock);
+			if (items.empty())
+				return false;
+			item = items.front();
+			items.pop_front();
+		}
+		not_full.notify_one();
+		return true;
+	}
+
+	// Stops accepting items, the items already queued can still be popped
+	void close()
+	{
+		{
+			std::unique_lock<std::mutex> lock(queue_mutex);
+			closed = true;
+		}
+		not_empty.notify_all();
+		not_full.notify_all();
+	}
+
+	// Number of queued items
+	std::size_t size()
+	{
+		std::unique_lock<std::mutex> lock(queue_mutex);
+		return items.size();
+	}
+
+	std::size_t get_capacity() const
+	{
+		return capacity;
+	}
+};
@@ -0,0 +1,53 @@
+/**
+  C++ Multithreaded Periodic Task Scheduler
+
+  Clock.cpp
+
+  Purpose:
+  Member function implementations of SystemClock and SimulatedClock
+
+  @version 1.0 10/18/2026
+*/
+#include "Clock.h"
+
+// Returns the shared system clock
+SystemClock &SystemClock::instance()
+{
+	static SystemClock clock;
+	return clock;
+}
+
+std::chrono::system_clock::time_point SystemClock::now()
+{
+	return std::chrono::system_clock::now();
+}
+
+void SystemClock::wait_until(std::condition_variable &cv, std::unique_lock<std::mutex> &lock, std::chrono::system_clock::time_point tp)
+{
+	cv.wait_until(lock, tp);
+}
+
+// SimulatedClock constructor
+SimulatedClock::SimulatedClock(const std::chrono::system_clock::time_point &start)
+	:current(start)
+{}
+
+std::chrono::system_clock::time_point SimulatedClock::now()
+{
+	std::unique_lock<std::mutex> lock(clock_mutex);
+	return current;
+}
+
+void SimulatedClock::wait_until(std::condition_variable &cv, std::unique_lock<std::mutex> &lock, std::chrono::system_clock::time_point tp)
+{
+	if (now() < tp)
+		cv.wait(lock);
+}
+
+// Moves the simulated time forward
+void SimulatedClock::advance_to(const std::chrono::system_clock::time_point &tp)
+{
+	std::unique_lock<std::mutex> lock(clock_mutex);
+	if (tp > current)
+		current = tp;
+}
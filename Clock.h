@@ -0,0 +1,99 @@
+/**
+  C++ Multithreaded Periodic Task Scheduler
+
+  Clock.h
+
+  Purpose:
+  Header file for the clocks the scheduler reads the time from
+
+  @version 1.0 10/18/2026
+*/
+#pragma once
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+
+/**
+	Clock
+
+	Source of the current time for the scheduler
+*/
+class Clock
+{
+public:
+	virtual ~Clock()
+	{}
+
+	/**
+	  Returns the current time
+
+	  @return Current time point
+	*/
+	virtual std::chrono::system_clock::time_point now() = 0;
+
+	/**
+	  Waits on a condition variable until it is notified or the time point is reached
+
+	  @param cv Condition variable to wait on
+	  @param lock Lock held on the mutex guarding the condition
+	  @param tp Time point to wait until, taken by value since the lock is released while waiting
+	*/
+	virtual void wait_until(std::condition_variable &cv, std::unique_lock<std::mutex> &lock, std::chrono::system_clock::time_point tp) = 0;
+};
+
+/**
+	SystemClock
+
+	Clock following the wall clock, used by default
+*/
+class SystemClock : public Clock
+{
+public:
+	/**
+	  Returns the shared system clock
+
+	  @return System clock instance
+	*/
+	static SystemClock &instance();
+
+	std::chrono::system_clock::time_point now() override;
+
+	void wait_until(std::condition_variable &cv, std::unique_lock<std::mutex> &lock, std::chrono::system_clock::time_point tp) override;
+};
+
+/**
+	SimulatedClock
+
+	Clock that only moves when advanced, used to run schedules faster than
+	real time with PeriodicScheduler::run_simulation. PeriodicScheduler::run
+	does not advance it and refuses it.
+
+	@member current Current simulated time
+	@member clock_mutex Mutex to lock while reading or advancing the time
+*/
+class SimulatedClock : public Clock
+{
+private:
+	std::chrono::system_clock::time_point current;
+	std::mutex clock_mutex;
+
+public:
+	/**
+	  SimulatedClock Constructor
+
+	  @param start Simulated time to start at
+	*/
+	SimulatedClock(const std::chrono::system_clock::time_point &start);
+
+	std::chrono::system_clock::time_point now() override;
+
+	// Simulated time does not pass while waiting, so only a notification ends the wait
+	void wait_until(std::condition_variable &cv, std::unique_lock<std::mutex> &lock, std::chrono::system_clock::time_point tp) override;
+
+	/**
+	  Moves the simulated time forward, earlier time points are ignored
+
+	  @param tp Time point to advance to
+	*/
+	void advance_to(const std::chrono::system_clock::time_point &tp);
+};
@@ -0,0 +1,887 @@
+/**
+  C++ Multithreaded Periodic Task Scheduler
+
+  ColumnarStore.cpp
+
+  Purpose:
+  Member function implementations of MappedFile, MetricSegment and ColumnarMetricStore
+
+  @version 1.0 10/18/2026
+*/
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+#include "ColumnarStore.h"
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define AGGREGATE_SSE2
+#endif
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+// Identifies a segment file ("SGMT")
+const std::uint32_t SEGMENT_MAGIC = 0x544D4753;
+const std::uint32_t SEGMENT_VERSION = 1;
+
+// Number of blocks a new segment file is created with
+const std::size_t INITIAL_BLOCKS = 16;
+
+// Number of bits available for samples in a block
+const std::uint32_t PAYLOAD_BITS = (BLOCK_BYTES - sizeof(BlockHeader)) * 8;
+
+// Number of independent accumulators the values of a range are reduced in
+const std::size_t AGGREGATE_LANES = 4;
+
+// Worst case size of one encoded sample: 4 + 64 bits timestamp, 2 + 5 + 6 + 64 bits value
+const std::uint32_t MAX_SAMPLE_BITS = 145;
+
+static_assert(sizeof(SegmentHeader) == 64, "SegmentHeader must be 64 bytes");
+static_assert(sizeof(BlockHeader) == 64, "BlockHeader must be 64 bytes");
+
+// Writes the low nbits of value to the bit stream, most significant bit first
+static void write_bits(std::uint8_t *buf, std::uint32_t &pos, std::uint64_t value, int nbits)
+{
+	for (int i = nbits - 1; i >= 0; i--)
+	{
+		if ((value >> i) & 1)
+			buf[pos >> 3] |= (std::uint8_t)(0x80 >> (pos & 7));
+		pos++;
+	}
+}
+
+// Reads nbits from the bit stream, most significant bit first
+static std::uint64_t read_bits(const std::uint8_t *buf, std::uint32_t &pos, int nbits)
+{
+	std::uint64_t value = 0;
+	for (int i = 0; i < nbits; i++)
+	{
+		value = (value << 1) | ((buf[pos >> 3] >> (7 - (pos & 7))) & 1);
+		pos++;
+	}
+	return value;
+}
+
+static int leading_zeros(std::uint64_t x)
+{
+	int n = 0;
+	while (n < 64 && !(x & (0x8000000000000000ULL >> n)))
+		n++;
+	return n;
+}
+
+static int trailing_zeros(std::uint64_t x)
+{
+	int n = 0;
+	while (n < 64 && !(x & (1ULL << n)))
+		n++;
+	return n;
+}
+
+static std::uint64_t double_to_bits(double value)
+{
+	std::uint64_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+	return bits;
+}
+
+static double bits_to_double(std::uint64_t bits)
+{
+	double value;
+	std::memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+// Merges the aggregates of a set of samples into agg
+static void merge_aggregates(Aggregates &agg, std::uint64_t count, double sum, double min, double max)
+{
+	if (!count)
+		return;
+	if (!agg.count)
+	{
+		agg.min = min;
+		agg.max = max;
+	}
+	else
+	{
+		agg.min = std::min(agg.min, min);
+		agg.max = std::max(agg.max, max);
+	}
+	agg.count += count;
+	agg.sum += sum;
+}
+
+/**
+  Aggregates the samples with a timestamp in [from, to] out of decoded block arrays.
+  Timestamps within a block are in order, so the samples in range are found by
+  binary search and their values reduced without any per-sample test. The
+  values are reduced in AGGREGATE_LANES independent lanes, with SSE2 where
+  available, since strict floating point keeps compilers from vectorizing a
+  single running sum, minimum and maximum.
+*/
+static void aggregate_samples(const std::int64_t *times, const double *values, std::uint32_t n, std::int64_t from, std::int64_t to, Aggregates &agg)
+{
+	const double inf = std::numeric_limits<double>::infinity();
+	std::uint32_t first = (std::uint32_t)(std::lower_bound(times, times + n, from) - times);
+	std::uint32_t last = (std::uint32_t)(std::upper_bound(times, times + n, to) - times);
+	double sum[AGGREGATE_LANES], min[AGGREGATE_LANES], max[AGGREGATE_LANES];
+	std::uint32_t i = first;
+
+	if (first >= last)
+		return;
+
+#ifdef AGGREGATE_SSE2
+	__m128d sum_lo = _mm_setzero_pd(), sum_hi = _mm_setzero_pd();
+	__m128d min_lo = _mm_set1_pd(inf), min_hi = _mm_set1_pd(inf);
+	__m128d max_lo = _mm_set1_pd(-inf), max_hi = _mm_set1_pd(-inf);
+
+	for (; i + AGGREGATE_LANES <= last; i += AGGREGATE_LANES)
+	{
+		__m128d lo = _mm_loadu_pd(values + i);
+		__m128d hi = _mm_loadu_pd(values + i + 2);
+		sum_lo = _mm_add_pd(sum_lo, lo);
+		sum_hi = _mm_add_pd(sum_hi, hi);
+		min_lo = _mm_min_pd(lo, min_lo);
+		min_hi = _mm_min_pd(hi, min_hi);
+		max_lo = _mm_max_pd(lo, max_lo);
+		max_hi = _mm_max_pd(hi, max_hi);
+	}
+	_mm_storeu_pd(sum, sum_lo);
+	_mm_storeu_pd(sum + 2, sum_hi);
+	_mm_storeu_pd(min, min_lo);
+	_mm_storeu_pd(min + 2, min_hi);
+	_mm_storeu_pd(max, max_lo);
+	_mm_storeu_pd(max + 2, max_hi);
+#else
+	for (std::size_t l = 0; l < AGGREGATE_LANES; l++)
+	{
+		sum[l] = 0;
+		min[l] = inf;
+		max[l] = -inf;
+	}
+	for (; i + AGGREGATE_LANES <= last; i += AGGREGATE_LANES)
+	{
+		for (std::size_t l = 0; l < AGGREGATE_LANES; l++)
+		{
+			double v = values[i + l];
+			sum[l] += v;
+			min[l] = v < min[l] ? v : min[l];
+			max[l] = v > max[l] ? v : max[l];
+		}
+	}
+#endif
+
+	// Samples left over after the last full set of lanes
+	for (std::size_t l = 0; i < last; i++, l++)
+	{
+		sum[l] += values[i];
+		min[l] = std::min(min[l], values[i]);
+		max[l] = std::max(max[l], values[i]);
+	}
+
+	// Lanes are combined once at the end
+	for (std::size_t l = 1; l < AGGREGATE_LANES; l++)
+	{
+		sum[0] += sum[l];
+		min[0] = std::min(min[0], min[l]);
+		max[0] = std::max(max[0], max[l]);
+	}
+	merge_aggregates(agg, last - first, sum[0], min[0], max[0]);
+}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+#ifdef _WIN32
+
+int MappedFile::open(const std::string &path, std::size_t min_size)
+{
+	HANDLE h = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (h == INVALID_HANDLE_VALUE)
+	{
+		fprintf(stderr, "Can't open segment file: %s\n", path.c_str());
+		return 0;
+	}
+	file = h;
+
+	LARGE_INTEGER file_size;
+	GetFileSizeEx(h, &file_size);
+	size = std::max((std::size_t)file_size.QuadPart, min_size);
+	return map();
+}
+
+int MappedFile::map()
+{
+	// Creating a mapping larger than the file extends the file
+	ULARGE_INTEGER map_size;
+	map_size.QuadPart = size;
+	mapping = CreateFileMappingA((HANDLE)file, NULL, PAGE_READWRITE, map_size.HighPart, map_size.LowPart, NULL);
+	if (!mapping)
+	{
+		fprintf(stderr, "Can't map segment file (%lu)\n", GetLastError());
+		return 0;
+	}
+	data = (std::uint8_t *)MapViewOfFile((HANDLE)mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+	if (!data)
+	{
+		fprintf(stderr, "Can't map segment file view (%lu)\n", GetLastError());
+		CloseHandle((HANDLE)mapping);
+		mapping = nullptr;
+		return 0;
+	}
+	return 1;
+}
+
+void MappedFile::unmap()
+{
+	if (data)
+		UnmapViewOfFile(data);
+	if (mapping)
+		CloseHandle((HANDLE)mapping);
+	data = nullptr;
+	mapping = nullptr;
+}
+
+void MappedFile::close()
+{
+	unmap();
+	if (file)
+		CloseHandle((HANDLE)file);
+	file = nullptr;
+	size = 0;
+}
+
+#else
+
+int MappedFile::open(const std::string &path, std::size_t min_size)
+{
+	fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+	if (fd < 0)
+	{
+		fprintf(stderr, "Can't open segment file: %s\n", path.c_str());
+		return 0;
+	}
+
+	struct stat st;
+	fstat(fd, &st);
+	size = (std::size_t)st.st_size;
+	if (size < min_size)
+	{
+		if (ftruncate(fd, min_size))
+		{
+			fprintf(stderr, "Can't extend segment file: %s\n", path.c_str());
+			return 0;
+		}
+		size = min_size;
+	}
+	return map();
+}
+
+int MappedFile::map()
+{
+	void *addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (addr == MAP_FAILED)
+	{
+		fprintf(stderr, "Can't map segment file\n");
+		return 0;
+	}
+	data = (std::uint8_t *)addr;
+	return 1;
+}
+
+void MappedFile::unmap()
+{
+	if (data)
+		munmap(data, size);
+	data = nullptr;
+}
+
+void MappedFile::close()
+{
+	unmap();
+	if (fd >= 0)
+		::close(fd);
+	fd = -1;
+	size = 0;
+}
+
+#endif
+
+// Extends the file and maps it again
+int MappedFile::resize(std::size_t new_size)
+{
+	unmap();
+#ifndef _WIN32
+	if (ftruncate(fd, new_size))
+	{
+		fprintf(stderr, "Can't extend segment file\n");
+		return 0;
+	}
+#endif
+	size = new_size;
+	return map();
+}
+
+// Checks that a block summary is sane enough for the block to be read
+static bool block_valid(const BlockHeader *b)
+{
+	return b->count && b->count <= BLOCK_SAMPLES && b->bits >= 64 && b->bits <= PAYLOAD_BITS && b->first_time <= b->last_time;
+}
+
+// Checks whether a block was never written to, its header is all zeros
+static bool block_unused(const BlockHeader *b)
+{
+	static const BlockHeader zero = {};
+	return !std::memcmp(b, &zero, sizeof(zero));
+}
+
+SegmentHeader *MetricSegment::header() const
+{
+	return (SegmentHeader *)file.get_data();
+}
+
+BlockHeader *MetricSegment::block(std::uint64_t index) const
+{
+	return (BlockHeader *)(file.get_data() + sizeof(SegmentHeader) + index * BLOCK_BYTES);
+}
+
+// Opens the segment file and validates its header
+int MetricSegment::open(const std::string &path)
+{
+	if (!file.open(path, sizeof(SegmentHeader) + INITIAL_BLOCKS * BLOCK_BYTES))
+		return 0;
+
+	SegmentHeader *hdr = header();
+	if (hdr->magic == 0)
+	{
+		// New segment file
+		hdr->magic = SEGMENT_MAGIC;
+		hdr->version = SEGMENT_VERSION;
+		hdr->block_count = 0;
+	}
+	else if (hdr->magic != SEGMENT_MAGIC || hdr->version != SEGMENT_VERSION)
+	{
+		fprintf(stderr, "Not a segment file: %s\n", path.c_str());
+		file.close();
+		return 0;
+	}
+
+	// Blocks are self-contained, so a damaged one is only skipped when read and the blocks
+	// after it stay readable. The block count is only cut back to blocks that lie within
+	// the file, dropping trailing blocks that were never written.
+	std::uint64_t fits = (file.get_size() - sizeof(SegmentHeader)) / BLOCK_BYTES;
+	std::uint64_t block_count = std::min(hdr->block_count, fits);
+	while (block_count > 0 && block_unused(block(block_count - 1)))
+		block_count--;
+	if (block_count != hdr->block_count)
+	{
+		fprintf(stderr, "Damaged segment file %s, %llu blocks recorded but %llu written\n", path.c_str(), (unsigned long long)hdr->block_count, (unsigned long long)block_count);
+		hdr->block_count = block_count;
+	}
+
+	std::uint64_t damaged = 0;
+	for (std::uint64_t i = 0; i < block_count; i++)
+	{
+		if (!block_valid(block(i)))
+			damaged++;
+	}
+	if (damaged)
+		fprintf(stderr, "Damaged segment file %s, skipping %llu of %llu blocks\n", path.c_str(), (unsigned long long)damaged, (unsigned long long)block_count);
+
+	// The encoder state of the last block is not persisted, so it is sealed
+	active = false;
+	return 1;
+}
+
+// Starts a new block, growing the file if it is full
+int MetricSegment::start_block(std::int64_t time, double value)
+{
+	std::uint64_t index = header()->block_count;
+	std::size_t needed = sizeof(SegmentHeader) + (index + 1) * BLOCK_BYTES;
+
+	if (needed > file.get_size())
+	{
+		if (!file.resize(std::max(needed, file.get_size() * 2)))
+			return 0;
+	}
+
+	BlockHeader *b = block(index);
+	std::memset(b, 0, BLOCK_BYTES);
+	b->first_time = time;
+	b->last_time = time;
+	b->sum = value;
+	b->min = value;
+	b->max = value;
+	b->count = 1;
+
+	// The first value of a block is written uncompressed
+	std::uint32_t pos = 0;
+	prev_value = double_to_bits(value);
+	write_bits((std::uint8_t *)(b + 1), pos, prev_value, 64);
+	b->bits = pos;
+
+	prev_time = time;
+	prev_delta = 0;
+	prev_leading = 65;
+	prev_trailing = 0;
+	active = true;
+	header()->block_count = index + 1;
+	return 1;
+}
+
+// Appends a sample to the last block, or to a new one if it is full
+int MetricSegment::append(std::int64_t time, double value)
+{
+	std::unique_lock<std::mutex> lock(segment_mutex);
+
+	if (!file.get_data())
+		return 0;
+
+	// Samples within a block are kept in time order so the block time range stays valid
+	if (!active || time < prev_time)
+		return start_block(time, value);
+
+	BlockHeader *b = block(header()->block_count - 1);
+	if (b->count >= BLOCK_SAMPLES || b->bits + MAX_SAMPLE_BITS > PAYLOAD_BITS)
+		return start_block(time, value);
+
+	std::uint8_t *payload = (std::uint8_t *)(b + 1);
+	std::uint32_t pos = b->bits;
+
+	// Timestamp as the delta of the delta to the previous one
+	std::int64_t delta = time - prev_time;
+	std::int64_t dod = delta - prev_delta;
+	if (dod == 0)
+	{
+		write_bits(payload, pos, 0, 1);
+	}
+	else if (dod >= -63 && dod <= 64)
+	{
+		write_bits(payload, pos, 0x2, 2);
+		write_bits(payload, pos, (std::uint64_t)(dod + 63), 7);
+	}
+	else if (dod >= -255 && dod <= 256)
+	{
+		write_bits(payload, pos, 0x6, 3);
+		write_bits(payload, pos, (std::uint64_t)(dod + 255), 9);
+	}
+	else if (dod >= -2047 && dod <= 2048)
+	{
+		write_bits(payload, pos, 0xE, 4);
+		write_bits(payload, pos, (std::uint64_t)(dod + 2047), 12);
+	}
+	else
+	{
+		write_bits(payload, pos, 0xF, 4);
+		write_bits(payload, pos, (std::uint64_t)dod, 64);
+	}
+
+	// Value as the XOR with the previous one
+	std::uint64_t bits = double_to_bits(value);
+	std::uint64_t x = bits ^ prev_value;
+	if (x == 0)
+	{
+		write_bits(payload, pos, 0, 1);
+	}
+	else
+	{
+		int leading = std::min(leading_zeros(x), 31);
+		int trailing = trailing_zeros(x);
+		if (leading >= prev_leading && trailing >= prev_trailing)
+		{
+			// Meaningful bits fit in the window of the previous value
+			write_bits(payload, pos, 0x2, 2);
+			write_bits(payload, pos, x >> prev_trailing, 64 - prev_leading - prev_trailing);
+		}
+		else
+		{
+			int meaningful = 64 - leading - trailing;
+			write_bits(payload, pos, 0x3, 2);
+			write_bits(payload, pos, leading, 5);
+			write_bits(payload, pos, meaningful - 1, 6);
+			write_bits(payload, pos, x >> trailing, meaningful);
+			prev_leading = leading;
+			prev_trailing = trailing;
+		}
+	}
+
+	b->bits = pos;
+	b->count++;
+	b->last_time = time;
+	b->sum += value;
+	b->min = std::min(b->min, value);
+	b->max = std::max(b->max, value);
+
+	prev_time = time;
+	prev_delta = delta;
+	prev_value = bits;
+	return 1;
+}
+
+// Decodes all samples of a block
+std::uint32_t MetricSegment::decode_block(std::uint64_t index, std::int64_t *times, double *values) const
+{
+	const BlockHeader *b = block(index);
+	const std::uint8_t *payload = (const std::uint8_t *)(b + 1);
+	std::uint32_t pos = 0;
+
+	if (!block_valid(b))
+		return 0;
+
+	std::int64_t time = b->first_time;
+	std::int64_t delta = 0;
+	std::uint64_t value = read_bits(payload, pos, 64);
+	int leading = 65, trailing = 0;
+	times[0] = time;
+	values[0] = bits_to_double(value);
+
+	std::uint32_t i = 1;
+	for (; i < b->count; i++)
+	{
+		// Every sample starts within the bits written by append, which leaves room for
+		// the largest sample, so a damaged payload can't make reads leave the block
+		if (pos >= b->bits || pos + MAX_SAMPLE_BITS > PAYLOAD_BITS)
+			break;
+
+		std::int64_t dod;
+		if (!read_bits(payload, pos, 1))
+			dod = 0;
+		else if (!read_bits(payload, pos, 1))
+			dod = (std::int64_t)read_bits(payload, pos, 7) - 63;
+		else if (!read_bits(payload, pos, 1))
+			dod = (std::int64_t)read_bits(payload, pos, 9) - 255;
+		else if (!read_bits(payload, pos, 1))
+			dod = (std::int64_t)read_bits(payload, pos, 12) - 2047;
+		else
+			dod = (std::int64_t)read_bits(payload, pos, 64);
+		delta += dod;
+		time += delta;
+
+		if (read_bits(payload, pos, 1))
+		{
+			if (!read_bits(payload, pos, 1))
+			{
+				value ^= read_bits(payload, pos, 64 - leading - trailing) << trailing;
+			}
+			else
+			{
+				leading = (int)read_bits(payload, pos, 5);
+				int meaningful = (int)read_bits(payload, pos, 6) + 1;
+				trailing = 64 - leading - meaningful;
+				if (trailing < 0)
+					break;
+				value ^= read_bits(payload, pos, meaningful) << trailing;
+			}
+		}
+		times[i] = time;
+		values[i] = bits_to_double(value);
+	}
+	return i;
+}
+
+// Aggregates the samples in [from, to], using the block summaries wherever a block lies entirely in the range
+void MetricSegment::aggregate(std::int64_t from, std::int64_t to, Aggregates &agg)
+{
+	std::int64_t times[BLOCK_SAMPLES];
+	double values[BLOCK_SAMPLES];
+
+	std::unique_lock<std::mutex> lock(segment_mutex);
+
+	if (!file.get_data())
+		return;
+
+	std::uint64_t block_count = header()->block_count;
+	for (std::uint64_t i = 0; i < block_count; i++)
+	{
+		// Damaged blocks are skipped, the blocks around them are read as usual
+		const BlockHeader *b = block(i);
+		if (!block_valid(b) || b->last_time < from || b->first_time > to)
+			continue;
+
+		if (b->first_time >= from && b->last_time <= to)
+		{
+			merge_aggregates(agg, b->count, b->sum, b->min, b->max);
+		}
+		else
+		{
+			std::uint32_t n = decode_block(i, times, values);
+			aggregate_samples(times, values, n, from, to, agg);
+		}
+	}
+}
+
+// ColumnarMetricStore constructor
+ColumnarMetricStore::ColumnarMetricStore(const std::string &dir)
+	:directory(dir)
+{
+#ifdef _WIN32
+	CreateDirectoryA(directory.c_str(), NULL);
+#else
+	mkdir(directory.c_str(), 0755);
+#endif
+}
+
+// Returns the segment of a metric, opening it on first use
+MetricSegment *ColumnarMetricStore::get_segment(const std::string &metric)
+{
+	std::unique_lock<std::mutex> lock(segments_mutex);
+
+	auto search = segments.find(metric);
+	if (search != segments.end())
+		return search->second.get();
+
+	std::unique_ptr<MetricSegment> segment(new MetricSegment());
+	if (!segment->open(directory + "/" + metric + ".seg"))
+		return nullptr;
+
+	MetricSegment *result = segment.get();
+	segments[metric] = std::move(segment);
+	return result;
+}
+
+// Appends the sample timestamped with the current time
+int ColumnarMetricStore::insert(const std::string &metric, double value)
+{
+	std::int64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+	return append(metric, now, value);
+}
+
+// Block summaries keep the aggregates, so the sample is all there is to store, timestamped with the time it was taken
+int ColumnarMetricStore::insert_sample(const std::string &metric, const std::chrono::system_clock::time_point &time, double value, const Aggregates &)
+{
+	return append(metric, std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()).count(), value);
+}
+
+// Aggregates kept in the block summaries make this independent of the number of samples
+int ColumnarMetricStore::get_aggregates(const std::string &metric, Aggregates &agg)
+{
+	return get_range_aggregates(metric, std::numeric_limits<std::int64_t>::min(), std::numeric_limits<std::int64_t>::max(), agg);
+}
+
+// Appends a sample with an explicit timestamp
+int ColumnarMetricStore::append(const std::string &metric, std::int64_t time, double value)
+{
+	MetricSegment *segment = get_segment(metric);
+	if (!segment)
+		return 0;
+	return segment->append(time, value);
+}
+
+// Gets the aggregates over the samples of a metric in [from, to]
+int ColumnarMetricStore::get_range_aggregates(const std::string &metric, std::int64_t from, std::int64_t to, Aggregates &agg)
+{
+	MetricSegment *segment = get_segment(metric);
+	if (!segment)
+		return 0;
+	agg = Aggregates();
+	segment->aggregate(from, to, agg);
+	return 1;
+}
+
+// Sample kept in memory by the codec check to compare the store against
+struct RawSample
+{
+	std::int64_t time;
+	double value;
+};
+
+// Compares the range aggregates of the store with those of the raw samples
+static int check_range(ColumnarMetricStore &store, const std::string &metric, const std::vector<RawSample> &samples, std::int64_t from, std::int64_t to)
+{
+	Aggregates expected, actual;
+	double scale = 1;
+
+	for (auto &s : samples)
+	{
+		if (s.time >= from && s.time <= to)
+		{
+			merge_aggregates(expected, 1, s.value, s.value, s.value);
+			scale += std::fabs(s.value);
+		}
+	}
+	if (!store.get_range_aggregates(metric, from, to, actual))
+		return 0;
+
+	// Sums are added up in a different order, so they only need to match up to rounding
+	if (actual.count != expected.count || std::fabs(actual.sum - expected.sum) > scale * 1e-12
+		|| (expected.count && (actual.min != expected.min || actual.max != expected.max)))
+	{
+		fprintf(stderr, "Range [%lld, %lld]: expected count %llu sum %.17g min %.17g max %.17g, got count %llu sum %.17g min %.17g max %.17g\n",
+			(long long)from, (long long)to,
+			(unsigned long long)expected.count, expected.sum, expected.min, expected.max,
+			(unsigned long long)actual.count, actual.sum, actual.min, actual.max);
+		return 0;
+	}
+	return 1;
+}
+
+// Checks whole, random and single sample ranges
+static int check_ranges(ColumnarMetricStore &store, const std::string &metric, const std::vector<RawSample> &samples, std::mt19937_64 &rng)
+{
+	std::int64_t first = samples.front().time, last = samples.front().time;
+
+	for (auto &s : samples)
+	{
+		first = std::min(first, s.time);
+		last = std::max(last, s.time);
+	}
+	if (!check_range(store, metric, samples, std::numeric_limits<std::int64_t>::min(), std::numeric_limits<std::int64_t>::max()))
+		return 0;
+	if (!check_range(store, metric, samples, last, first - 1))
+		return 0;
+
+	std::uniform_int_distribution<std::int64_t> time(first - 1000, last + 1000);
+	std::uniform_int_distribution<std::size_t> index(0, samples.size() - 1);
+	for (int i = 0; i < 500; i++)
+	{
+		std::int64_t a = time(rng), b = time(rng);
+		if (!check_range(store, metric, samples, std::min(a, b), std::max(a, b)))
+			return 0;
+
+		std::int64_t t = samples[index(rng)].time;
+		if (!check_range(store, metric, samples, t, t))
+			return 0;
+	}
+	return 1;
+}
+
+// Overwrites part of a file
+static int patch_file(const std::string &path, std::size_t offset, const void *data, std::size_t size)
+{
+	FILE *f = fopen(path.c_str(), "r+b");
+	if (!f)
+		return 0;
+	fseek(f, (long)offset, SEEK_SET);
+	std::size_t written = fwrite(data, 1, size, f);
+	fclose(f);
+	return written == size;
+}
+
+// Reads part of a file
+static int read_file(const std::string &path, std::size_t offset, void *data, std::size_t size)
+{
+	FILE *f = fopen(path.c_str(), "rb");
+	if (!f)
+		return 0;
+	fseek(f, (long)offset, SEEK_SET);
+	std::size_t read = fread(data, 1, size, f);
+	fclose(f);
+	return read == size;
+}
+
+// Checks the segment codec and range aggregates against the raw samples
+int verify_columnar_store(const std::string &dir)
+{
+	const std::string metric = "CODEC_CHECK";
+	const std::string path = dir + "/" + metric + ".seg";
+	std::vector<RawSample> samples;
+	std::mt19937_64 rng(20170514);
+	std::uniform_real_distribution<double> unit(0, 1);
+	std::int64_t time = 1494720000000;
+	double value = 1 << 20;
+
+	std::remove(path.c_str());
+
+	// Series covering every timestamp encoding (equal deltas, jitter of each size, large
+	// gaps, going backwards) and value encoding (equal, slowly and randomly changing)
+	for (int round = 0; round < 2; round++)
+	{
+		ColumnarMetricStore store(dir);
+		for (int i = 0; i < 6000; i++)
+		{
+			int phase = (i / 250) % 8;
+			std::int64_t delta = 1000;
+			if (phase == 1)
+				delta += (std::int64_t)(unit(rng) * 120) - 60;
+			else if (phase == 2)
+				delta += (std::int64_t)(unit(rng) * 500) - 250;
+			else if (phase == 3)
+				delta += (std::int64_t)(unit(rng) * 4000) - 2000;
+			else if (phase == 4)
+				delta = (std::int64_t)(unit(rng) * 1e12);
+			else if (phase == 5 && i % 50 == 0)
+				delta = -(std::int64_t)(unit(rng) * 1e6);
+			time += delta;
+
+			if (phase == 6)
+				value = (unit(rng) - 0.5) * std::pow(10.0, (int)(unit(rng) * 40) - 20);
+			else if (phase == 7)
+				value = (double)(std::int64_t)(value + unit(rng) * 4096);
+			else if (i % 3 == 0)
+				value += 4096;
+
+			if (!store.append(metric, time, value))
+				return 0;
+			samples.push_back({ time, value });
+		}
+
+		// The second round appends after reopening the segment
+		if (!check_ranges(store, metric, samples, rng))
+			return 0;
+	}
+
+	// A block count beyond the blocks written is cut back to them
+	std::uint64_t written = 0, reopened = 0;
+	std::uint64_t bogus = 1ULL << 40;
+	if (!read_file(path, offsetof(SegmentHeader, block_count), &written, sizeof(written))
+		|| !patch_file(path, offsetof(SegmentHeader, block_count), &bogus, sizeof(bogus)))
+		return 0;
+	{
+		ColumnarMetricStore store(dir);
+		if (!check_ranges(store, metric, samples, rng))
+			return 0;
+	}
+	if (!read_file(path, offsetof(SegmentHeader, block_count), &reopened, sizeof(reopened)) || reopened != written)
+		return 0;
+
+	// Damaged block summaries and payloads must not make reads leave the file
+	BlockHeader damaged_payload, damaged_summary;
+	if (!read_file(path, sizeof(SegmentHeader) + 3 * BLOCK_BYTES, &damaged_payload, sizeof(BlockHeader))
+		|| !read_file(path, sizeof(SegmentHeader) + 5 * BLOCK_BYTES, &damaged_summary, sizeof(BlockHeader)))
+		return 0;
+	std::uint32_t count = BLOCK_SAMPLES + 1;
+	std::vector<std::uint8_t> garbage(BLOCK_BYTES - sizeof(BlockHeader));
+	for (auto &byte : garbage)
+		byte = (std::uint8_t)rng();
+	if (!patch_file(path, sizeof(SegmentHeader) + 3 * BLOCK_BYTES + sizeof(BlockHeader), garbage.data(), garbage.size())
+		|| !patch_file(path, sizeof(SegmentHeader) + 5 * BLOCK_BYTES + offsetof(BlockHeader, count), &count, sizeof(count)))
+		return 0;
+	{
+		ColumnarMetricStore store(dir);
+		std::uniform_int_distribution<std::size_t> index(0, samples.size() - 1);
+		for (int i = 0; i < 500; i++)
+		{
+			// Ranges ending inside a block make it decode its payload
+			Aggregates agg;
+			std::int64_t a = samples[index(rng)].time, b = samples[index(rng)].time;
+			if (!store.get_range_aggregates(metric, std::min(a, b), std::max(a, b), agg) || agg.count > samples.size())
+				return 0;
+		}
+
+		// The blocks after the damaged ones are still read in full
+		std::int64_t after = std::max(damaged_payload.last_time, damaged_summary.last_time) + 1;
+		Aggregates tail;
+		if (!store.get_range_aggregates(metric, after, std::numeric_limits<std::int64_t>::max(), tail) || !tail.count
+			|| !check_range(store, metric, samples, after, std::numeric_limits<std::int64_t>::max()))
+			return 0;
+	}
+	if (!read_file(path, offsetof(SegmentHeader, block_count), &reopened, sizeof(reopened)) || reopened != written)
+		return 0;
+
+	std::remove(path.c_str());
+	return 1;
+}
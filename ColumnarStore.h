@@ -0,0 +1,264 @@
+/**
+  C++ Multithreaded Periodic Task Scheduler
+
+  ColumnarStore.h
+
+  Purpose:
+  Header file for the memory-mapped, compressed columnar MetricStore backend
+
+  Every metric is kept in its own append-only segment file, made of fixed
+  size blocks. A block starts with a header summarising its samples
+  (time range, count, sum, minimum and maximum) followed by a bit stream
+  of delta-of-delta encoded timestamps and XOR compressed values.
+
+  @version 1.0 10/18/2026
+*/
+#pragma once
+#include "MetricStore.h"
+#include <mutex>
+#include <memory>
+#include <unordered_map>
+
+// Size of one block in a segment file, header included
+const std::size_t BLOCK_BYTES = 4096;
+
+// Maximum number of samples held by one block
+const std::size_t BLOCK_SAMPLES = 512;
+
+/**
+	SegmentHeader Structure, stored at the start of every segment file
+
+	@member magic Identifies the file as a segment file
+	@member version Segment file format version
+	@member block_count Number of blocks written to the segment
+*/
+struct SegmentHeader
+{
+	std::uint32_t magic;
+	std::uint32_t version;
+	std::uint64_t block_count;
+	std::uint8_t reserved[48];
+};
+
+/**
+	BlockHeader Structure, stored at the start of every block
+
+	@member first_time Timestamp of the first sample in milliseconds
+	@member last_time Timestamp of the last sample in milliseconds
+	@member sum Sum of all sample values
+	@member min Minimum sample value
+	@member max Maximum sample value
+	@member count Number of samples in the block
+	@member bits Number of bits used in the block payload
+*/
+struct BlockHeader
+{
+	std::int64_t first_time;
+	std::int64_t last_time;
+	double sum;
+	double min;
+	double max;
+	std::uint32_t count;
+	std::uint32_t bits;
+	std::uint8_t reserved[16];
+};
+
+/**
+	MappedFile
+
+	File mapped into memory which can be grown in place
+
+	@member data Start of the mapping
+	@member size Size of the file and the mapping in bytes
+*/
+class MappedFile
+{
+private:
+	std::uint8_t *data = nullptr;
+	std::size_t size = 0;
+#ifdef _WIN32
+	void *file = nullptr;
+	void *mapping = nullptr;
+#else
+	int fd = -1;
+#endif
+
+	// Maps the whole file into memory
+	int map();
+
+	// Unmaps the file from memory
+	void unmap();
+
+public:
+	~MappedFile();
+
+	/**
+	  Opens or creates a file and maps it into memory
+
+	  @param path File path
+	  @param min_size Size the file is extended to if it is smaller
+	  @return returns 1 if successfull else 0
+	*/
+	int open(const std::string &path, std::size_t min_size);
+
+	/**
+	  Extends the file and remaps it. Pointers into the old mapping are invalidated.
+
+	  @param new_size New size of the file in bytes
+	  @return returns 1 if successfull else 0
+	*/
+	int resize(std::size_t new_size);
+
+	// Closes the file
+	void close();
+
+	std::uint8_t *get_data() const
+	{
+		return data;
+	}
+
+	std::size_t get_size() const
+	{
+		return size;
+	}
+};
+
+/**
+	MetricSegment
+
+	Append-only segment file of a single metric along with the state of
+	the encoder writing to the last block
+
+	@member file Memory mapped segment file
+	@member segment_mutex Mutex to lock while appending to or reading from the segment
+	@member active Whether the last block accepts further samples
+	@member prev_time Timestamp of the previous sample
+	@member prev_delta Delta between the previous two timestamps
+	@member prev_value Bits of the previous value
+	@member prev_leading Leading zeros of the previous XOR written with its own window
+	@member prev_trailing Trailing zeros of the previous XOR written with its own window
+*/
+class MetricSegment
+{
+private:
+	MappedFile file;
+	std::mutex segment_mutex;
+	bool active = false;
+	std::int64_t prev_time = 0;
+	std::int64_t prev_delta = 0;
+	std::uint64_t prev_value = 0;
+	int prev_leading = 0;
+	int prev_trailing = 0;
+
+	SegmentHeader *header() const;
+
+	BlockHeader *block(std::uint64_t index) const;
+
+	// Starts a new block with the given sample
+	int start_block(std::int64_t time, double value);
+
+	/**
+	  Decodes a block into timestamp and value arrays
+
+	  @param index Block index
+	  @param times Output timestamps, BLOCK_SAMPLES long
+	  @param values Output values, BLOCK_SAMPLES long
+	  @return Number of samples decoded
+	*/
+	std::uint32_t decode_block(std::uint64_t index, std::int64_t *times, double *values) const;
+
+public:
+	/**
+	  Opens the segment file of a metric, creating it if it does not exist.
+	  Samples appended after reopening start in a new block. Damaged blocks are
+	  reported and skipped when read, only blocks recorded past the last one
+	  written are dropped.
+
+	  @param path Segment file path
+	  @return returns 1 if successfull else 0
+	*/
+	int open(const std::string &path);
+
+	/**
+	  Appends a sample to the segment
+
+	  @param time Sample timestamp in milliseconds
+	  @param value Sample value
+	  @return returns 1 if successfull else 0
+	*/
+	int append(std::int64_t time, double value);
+
+	/**
+	  Aggregates the samples with a timestamp in [from, to]
+
+	  @param from Start of the range in milliseconds
+	  @param to End of the range in milliseconds
+	  @param agg Aggregates of the range
+	*/
+	void aggregate(std::int64_t from, std::int64_t to, Aggregates &agg);
+};
+
+/**
+	ColumnarMetricStore
+
+	MetricStore backend keeping one memory-mapped segment file per metric
+
+	@member directory Directory holding the segment files
+	@member segments Open segments by metric name
+	@member segments_mutex Mutex to lock while looking up or opening segments
+*/
+class ColumnarMetricStore : public MetricStore
+{
+private:
+	std::string directory;
+	std::unordered_map<std::string, std::unique_ptr<MetricSegment>> segments;
+	std::mutex segments_mutex;
+
+	// Returns the segment of a metric, opening it if needed
+	MetricSegment *get_segment(const std::string &metric);
+
+public:
+	/**
+	  ColumnarMetricStore Constructor
+
+	  @param dir Directory holding the segment files, created if it does not exist
+	*/
+	ColumnarMetricStore(const std::string &dir);
+
+	int insert(const std::string &metric, double value) override;
+
+	int insert_sample(const std::string &metric, const std::chrono::system_clock::time_point &time, double value, const Aggregates &agg) override;
+
+	int get_aggregates(const std::string &metric, Aggregates &agg) override;
+
+	/**
+	  Appends a sample with an explicit timestamp
+
+	  @param metric Metric name
+	  @param time Sample timestamp in milliseconds since epoch
+	  @param value Sample value
+	  @return returns 1 if successfull else 0
+	*/
+	int append(const std::string &metric, std::int64_t time, double value);
+
+	/**
+	  Gets the aggregates over the samples of a metric with a timestamp in [from, to]
+
+	  @param metric Metric name
+	  @param from Start of the range in milliseconds since epoch
+	  @param to End of the range in milliseconds since epoch
+	  @param agg Aggregates of the range
+	  @return returns 1 if successfull else 0
+	*/
+	int get_range_aggregates(const std::string &metric, std::int64_t from, std::int64_t to, Aggregates &agg);
+};
+
+/**
+  Function to check the segment codec and range aggregates against the raw samples.
+  Writes a series covering every timestamp and value encoding, reopening and
+  out of order samples, then damages the segment file and reopens it.
+
+  @param dir Directory the check's segment file is written to and removed from
+  @return returns 1 if successfull else 0
+*/
+int verify_columnar_store(const std::string &dir);
@@ -0,0 +1,127 @@
+/**
+  C++ Multithreaded Periodic Task Scheduler
+
+  ConnectionManager.cpp
+
+  Purpose:
+  Member function implementations of ConnectionManager
+
+  @version 1.0 10/18/2026
+*/
+#include <iostream>
+#include "ConnectionManager.h"
+#include "task_sqlite.h"
+
+// Milliseconds a connection waits on a locked database before failing
+const int BUSY_TIMEOUT = 5000;
+
+// Closes a thread's reader connection when the thread exits
+static void close_reader(sqlite3 *db)
+{
+	sqlite3_close(db);
+}
+
+// ConnectionManager constructor
+ConnectionManager::ConnectionManager(const std::string &file)
+	:db_file(file),
+	reader(close_reader)
+{}
+
+// Closes the writer connection
+ConnectionManager::~ConnectionManager()
+{
+	reader.reset();
+	if (writer)
+		sqlite3_close(writer);
+}
+
+// Opens the writer connection and switches the database to WAL mode
+int ConnectionManager::open()
+{
+	// Access to the writer is serialized by writer_mutex, so SQLite's own mutex is not needed
+	if (sqlite3_open_v2(db_file.c_str(), &writer, SQLITE_OPEN_READWRITE | SQLITE_OPEN_NOMUTEX, NULL))
+	{
+		fprintf(stderr, "Can't open database: %s\n", db_file.c_str());
+		sqlite3_close(writer);
+		writer = NULL;
+		return 0;
+	}
+	sqlite3_busy_timeout(writer, BUSY_TIMEOUT);
+
+	// WAL mode is persistent, readers opened later pick it up from the database file
+	if (!execute_statement(writer, "PRAGMA journal_mode=WAL") || !execute_statement(writer, "PRAGMA synchronous=NORMAL"))
+	{
+		sqlite3_close(writer);
+		writer = NULL;
+		return 0;
+	}
+	return 1;
+}
+
+// Locks and returns the writer connection
+sqlite3 *ConnectionManager::acquire_writer(std::unique_lock<std::mutex> &lock)
+{
+	lock = std::unique_lock<std::mutex>(writer_mutex);
+	return writer;
+}
+
+// Returns the read-only connection of the calling thread, opening it on first use
+sqlite3 *ConnectionManager::get_reader()
+{
+	if (!reader.get())
+	{
+		sqlite3 *db = NULL;
+		if (sqlite3_open_v2(db_file.c_str(), &db, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX, NULL))
+		{
+			fprintf(stderr, "Can't open reader connection: %s\n", db_file.c_str());
+			sqlite3_close(db);
+			return NULL;
+		}
+		sqlite3_busy_timeout(db, BUSY_TIMEOUT);
+		reader.reset(db);
+	}
+	return reader.get();
+}
+
+// Gets the aggregates of several metrics inside one read transaction
+int ConnectionManager::snapshot_aggregates(const std::vector<std::string> &metrics, std::vector<Aggregates> &aggs)
+{
+	int rc;
+	sqlite3_stmt *stmt;
+	sqlite3 *db = get_reader();
+
+	if (!db)
+		return 0;
+
+	// Under WAL every statement of a read transaction sees the database as of its first read
+	if (!execute_statement(db, "BEGIN"))
+		return 0;
+
+	aggs.assign(metrics.size(), Aggregates());
+	for (std::size_t i = 0; i < metrics.size(); i++)
+	{
+		std::string str = "SELECT COUNT(Val), TOTAL(Val), MIN(Val), MAX(Val) from " + metrics[i];
+
+		if (SQLITE_OK != sqlite3_prepare_v2(db, str.c_str(), -1, &stmt, 0))
+		{
+			fprintf(stderr, "Snapshot Prepare error: %s", sqlite3_errmsg(db));
+			execute_statement(db, "ROLLBACK");
+			return 0;
+		}
+
+		rc = sqlite3_step(stmt);
+		if (rc != SQLITE_ROW)
+		{
+			fprintf(stderr, "Snapshot Step error (%d): %s", rc, sqlite3_errmsg(db));
+			sqlite3_finalize(stmt);
+			execute_statement(db, "ROLLBACK");
+			return 0;
+		}
+		aggs[i].count = sqlite3_column_int64(stmt, 0);
+		aggs[i].sum = sqlite3_column_double(stmt, 1);
+		aggs[i].min = sqlite3_column_double(stmt, 2);
+		aggs[i].max = sqlite3_column_double(stmt, 3);
+		sqlite3_finalize(stmt);
+	}
+	return execute_statement(db, "COMMIT");
+}
@@ -0,0 +1,81 @@
+/**
+  C++ Multithreaded Periodic Task Scheduler
+
+  ConnectionManager.h
+
+  Purpose:
+  Header file for ConnectionManager which hands out SQLite connections to threads
+
+  @version 1.0 10/18/2026
+*/
+#pragma once
+#include <sqlite3.h>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <boost\thread.hpp>
+#include "MetricStore.h"
+
+/**
+	ConnectionManager
+
+	Keeps a single writer connection and one read-only connection per thread.
+	The database is switched to WAL mode so that readers see a consistent
+	snapshot without blocking the writer and vice versa.
+
+	@member db_file Database file name
+	@member writer Writer connection
+	@member writer_mutex Mutex to lock while using the writer connection
+	@member reader Read-only connection of the calling thread
+*/
+class ConnectionManager
+{
+private:
+	std::string db_file;
+	sqlite3 *writer = nullptr;
+	std::mutex writer_mutex;
+	boost::thread_specific_ptr<sqlite3> reader;
+
+public:
+	/**
+	  ConnectionManager Constructor
+
+	  @param file Database file name
+	*/
+	ConnectionManager(const std::string &file);
+
+	// Closes the writer connection
+	~ConnectionManager();
+
+	/**
+	  Opens the writer connection and switches the database to WAL mode
+
+	  @return returns 1 if successfull else 0
+	*/
+	int open();
+
+	/**
+	  Locks and returns the writer connection. The connection may only be used while lock is held.
+
+	  @param lock Lock on the writer connection
+	  @return Writer connection pointer
+	*/
+	sqlite3 *acquire_writer(std::unique_lock<std::mutex> &lock);
+
+	/**
+	  Returns the read-only connection of the calling thread, opening it on first use.
+	  The connection is closed when the thread exits.
+
+	  @return Reader connection pointer, NULL if it could not be opened
+	*/
+	sqlite3 *get_reader();
+
+	/**
+	  Gets the aggregates of several metrics from a single consistent snapshot
+
+	  @param metrics Metric table names
+	  @param aggs Aggregates of each metric, in the same order as metrics
+	  @return returns 1 if successfull else 0
+	*/
+	int snapshot_aggregates(const std::vector<std::string> &metrics, std::vector<Aggregates> &aggs);
+};
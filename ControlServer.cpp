@@ -0,0 +1,392 @@
+/**
+  C++ Multithreaded Periodic Task Scheduler
+
+  ControlServer.cpp
+
+  Purpose:
+  Member function implementations of ControlServer and its client sessions
+
+  @version 1.0 10/18/2026
+*/
+#include "ControlServer.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <unordered_set>
+
+// Largest request frame accepted, length prefix excluded
+const std::uint32_t MAX_FRAME_BYTES = 64;
+
+// Size of the response frame, length prefix excluded
+const std::uint32_t RESPONSE_BYTES = 9;
+
+// Unsent responses above which a session stops reading until the client catches up
+const std::size_t MAX_QUEUED_RESPONSES = 1 << 20;
+
+// Delay before accepting again after a failed accept, such as running out of file descriptors
+const std::chrono::milliseconds ACCEPT_RETRY_DELAY(100);
+
+static std::uint32_t read_u32(const std::uint8_t *p)
+{
+	return (std::uint32_t)p[0] | ((std::uint32_t)p[1] << 8) | ((std::uint32_t)p[2] << 16) | ((std::uint32_t)p[3] << 24);
+}
+
+static void write_u32(std::vector<std::uint8_t> &out, std::uint32_t v)
+{
+	out.push_back((std::uint8_t)v);
+	out.push_back((std::uint8_t)(v >> 8));
+	out.push_back((std::uint8_t)(v >> 16));
+	out.push_back((std::uint8_t)(v >> 24));
+}
+
+// ControlServer constructor
+ControlServer::ControlServer(PeriodicScheduler &s, const std::string &path, unsigned short p)
+	:scheduler(s),
+	socket_path(path),
+	port(p),
+	accept_retry(io)
+{}
+
+// Stops the server
+ControlServer::~ControlServer()
+{
+	stop();
+}
+
+// Registers a task type that OP_ADD requests can refer to
+void ControlServer::register_task_type(std::uint8_t type, const std::string &name, boost::function<void()> func)
+{
+	task_types[type] = TaskType{ name, func };
+}
+
+/**
+	ControlAck Structure, response to one request of a batch
+
+	@member request_id Request ID the client sent
+	@member status Response status
+	@member uid Task ID the request refers to
+	@member update Index of the request in the batch's updates, -1 if it is not an update
+	@member remove Index of the request in the batch's deletes, -1 if it is not a delete
+*/
+struct ControlAck
+{
+	std::uint32_t request_id;
+	std::uint8_t status;
+	std::uint32_t uid;
+	int update;
+	int remove;
+};
+
+// Applies all complete request frames in the buffer to the scheduler as one batch
+std::size_t ControlServer::process(const std::uint8_t *data, std::size_t size, std::vector<std::uint8_t> &responses)
+{
+	std::vector<Task> added;
+	std::vector<std::pair<std::uint32_t, int>> updates;
+	std::vector<std::uint32_t> deletes;
+	std::vector<ControlAck> acks;
+	std::unordered_set<std::uint32_t> batch_deletes;
+	auto now = scheduler.get_clock().now();
+	std::size_t pos = 0;
+	bool invalid = false;
+
+	while (size - pos >= 4)
+	{
+		std::uint32_t length = read_u32(data + pos);
+		if (length < 5 || length > MAX_FRAME_BYTES)
+		{
+			// The frames before it are still applied and acknowledged
+			invalid = true;
+			break;
+		}
+		if (size - pos - 4 < length)
+			break;
+
+		const std::uint8_t *frame = data + pos + 4;
+		const std::uint8_t *payload = frame + 5;
+		std::uint32_t payload_length = length - 5;
+		std::uint8_t op = frame[0];
+		ControlAck ack = { read_u32(frame + 1), STATUS_OK, 0, -1, -1 };
+
+		if (op == OP_ADD && (payload_length == 5 || payload_length == 6))
+		{
+			auto type = task_types.find(payload[0]);
+			std::uint32_t interval = read_u32(payload + 1);
+			if (type == task_types.end())
+				ack.status = STATUS_UNKNOWN_TYPE;
+			else if (interval == 0 || interval > INT32_MAX)
+				ack.status = STATUS_BAD_INTERVAL;
+			else
+			{
+				ack.uid = PeriodicScheduler::getUid();
+				added.push_back(Task(ack.uid, type->second.name, type->second.func, now, std::chrono::seconds(interval)));
+
+				// Optional NUMA node the task is pinned to
+				if (payload_length == 6 && payload[5] != 0xFF)
+					added.back().node = payload[5];
+			}
+		}
+		else if (op == OP_UPDATE && payload_length == 8)
+		{
+			ack.uid = read_u32(payload);
+			std::uint32_t interval = read_u32(payload + 4);
+			if (interval == 0 || interval > INT32_MAX)
+				ack.status = STATUS_BAD_INTERVAL;
+			else if (batch_deletes.count(ack.uid))
+				ack.status = STATUS_UNKNOWN_TASK;
+			else
+			{
+				ack.update = (int)updates.size();
+				updates.push_back(std::make_pair(ack.uid, (int)interval));
+			}
+		}
+		else if (op == OP_DELETE && payload_length == 4)
+		{
+			ack.uid = read_u32(payload);
+			if (!batch_deletes.insert(ack.uid).second)
+				ack.status = STATUS_UNKNOWN_TASK;
+			else
+			{
+				ack.remove = (int)deletes.size();
+				deletes.push_back(ack.uid);
+			}
+		}
+		else
+		{
+			ack.status = STATUS_MALFORMED;
+		}
+		acks.push_back(ack);
+
+		pos += 4 + length;
+	}
+
+	// Deletes are applied last so that a task added and deleted in the same batch is removed.
+	// Updates following a delete of the same task in the batch were refused above, so
+	// acknowledging updates before deletes matches the order of the requests.
+	std::vector<int> updated, deleted;
+	scheduler.schedule_batch(added);
+	scheduler.update_tasks(updates, updated);
+	scheduler.delete_tasks(deletes, deleted);
+
+	// Acknowledge every request with the uid of the task it refers to
+	for (auto &ack : acks)
+	{
+		if ((ack.update >= 0 && !updated[ack.update]) || (ack.remove >= 0 && !deleted[ack.remove]))
+			ack.status = STATUS_UNKNOWN_TASK;
+
+		write_u32(responses, RESPONSE_BYTES);
+		responses.push_back(ack.status);
+		write_u32(responses, ack.request_id);
+		write_u32(responses, ack.uid);
+	}
+	return invalid ? PROTOCOL_ERROR : pos;
+}
+
+/**
+	ControlSession
+
+	Connection of one control client. Only ever used from the IO thread.
+
+	@member socket Client socket
+	@member server Server the requests are processed by
+	@member chunk Buffer for a single read
+	@member pending Received bytes not yet forming a complete frame
+	@member outgoing Responses being written
+	@member queued Responses produced while a write is in flight
+	@member writing Whether a write is in flight
+	@member reading Whether a read is in flight
+	@member closing Whether the connection is closed once the queued responses are written
+*/
+class ControlSession : public std::enable_shared_from_this<ControlSession>
+{
+private:
+	control_protocol::socket socket;
+	ControlServer &server;
+	std::array<std::uint8_t, 65536> chunk;
+	std::vector<std::uint8_t> pending;
+	std::vector<std::uint8_t> outgoing;
+	std::vector<std::uint8_t> queued;
+	bool writing = false;
+	bool reading = false;
+	bool closing = false;
+
+public:
+	ControlSession(boost::asio::io_service &io, ControlServer &s)
+		:socket(io),
+		server(s)
+	{}
+
+	control_protocol::socket &get_socket()
+	{
+		return socket;
+	}
+
+	// Closes the connection, pending reads and writes complete with an error
+	void close()
+	{
+		boost::system::error_code ec;
+		socket.close(ec);
+	}
+
+	// Reads the next chunk of requests, unless the client is not reading its responses
+	void read()
+	{
+		if (reading || closing || queued.size() >= MAX_QUEUED_RESPONSES)
+			return;
+		reading = true;
+
+		auto self = shared_from_this();
+		socket.async_read_some(boost::asio::buffer(chunk), [this, self](const boost::system::error_code &ec, std::size_t n)
+		{
+			reading = false;
+			if (ec)
+				return;
+
+			pending.insert(pending.end(), chunk.begin(), chunk.begin() + n);
+			std::size_t consumed = server.process(pending.data(), pending.size(), queued);
+			if (consumed == PROTOCOL_ERROR)
+			{
+				// Frame boundaries are lost, the connection can't be recovered. The
+				// requests before the bad frame were applied, so their responses are sent first.
+				closing = true;
+				write();
+				if (!writing)
+					socket.close();
+				return;
+			}
+			pending.erase(pending.begin(), pending.begin() + consumed);
+
+			write();
+			read();
+		});
+	}
+
+	// Writes all queued responses in one go
+	void write()
+	{
+		if (writing || queued.empty())
+			return;
+		writing = true;
+		outgoing.swap(queued);
+		queued.clear();
+
+		auto self = shared_from_this();
+		boost::asio::async_write(socket, boost::asio::buffer(outgoing), [this, self](const boost::system::error_code &ec, std::size_t)
+		{
+			writing = false;
+			outgoing.clear();
+			if (ec)
+				return;
+			write();
+			if (closing && !writing)
+			{
+				socket.close();
+				return;
+			}
+
+			// Resume reading if it was paused for the client to catch up
+			read();
+		});
+	}
+};
+
+// Starts listening on the socket in a new thread
+int ControlServer::start()
+{
+	boost::system::error_code ec;
+
+#ifdef CONTROL_LOCAL_SOCKET
+	// Remove the socket file left behind by a previous run
+	std::remove(socket_path.c_str());
+	control_protocol::endpoint endpoint(socket_path);
+	std::string address = socket_path;
+#else
+	// Only reachable from this machine, like a Unix domain socket
+	control_protocol::endpoint endpoint(boost::asio::ip::address_v4::loopback(), port);
+	std::string address = "127.0.0.1:" + std::to_string(port);
+#endif
+
+	acceptor.reset(new control_protocol::acceptor(io));
+	acceptor->open(endpoint.protocol(), ec);
+#ifndef CONTROL_LOCAL_SOCKET
+	if (!ec)
+		acceptor->set_option(boost::asio::socket_base::reuse_address(true), ec);
+#endif
+	if (!ec)
+		acceptor->bind(endpoint, ec);
+	if (!ec)
+		acceptor->listen(boost::asio::socket_base::max_connections, ec);
+	if (ec)
+	{
+		fprintf(stderr, "Can't listen on control socket %s: %s\n", address.c_str(), ec.message().c_str());
+		acceptor.reset();
+		return 0;
+	}
+
+	accept();
+	io_thread = boost::thread([this] { io.run(); });
+	return 1;
+}
+
+// Accepts the next client connection
+void ControlServer::accept()
+{
+	std::shared_ptr<ControlSession> session = std::make_shared<ControlSession>(io, *this);
+
+	acceptor->async_accept(session->get_socket(), [this, session](const boost::system::error_code &ec)
+	{
+		if (ec == boost::asio::error::operation_aborted)
+			return;
+		if (ec)
+		{
+			// Errors such as running out of file descriptors or a client giving up are usually
+			// temporary, so accepting is retried after a short delay rather than given up or spun on
+			fprintf(stderr, "Unable to accept control connection: %s\n", ec.message().c_str());
+			accept_retry.expires_from_now(ACCEPT_RETRY_DELAY);
+			accept_retry.async_wait([this](const boost::system::error_code &timer_ec)
+			{
+				if (!timer_ec)
+					accept();
+			});
+			return;
+		}
+
+		// Sessions that have ended are dropped from the list as new ones arrive
+		sessions.erase(std::remove_if(sessions.begin(), sessions.end(), [](const std::weak_ptr<ControlSession> &s) { return s.expired(); }), sessions.end());
+		sessions.push_back(session);
+#ifndef CONTROL_LOCAL_SOCKET
+		// Responses are small, send them without waiting to fill a packet
+		boost::system::error_code option_ec;
+		session->get_socket().set_option(boost::asio::ip::tcp::no_delay(true), option_ec);
+#endif
+		session->read();
+		accept();
+	});
+}
+
+// Stops listening and closes all client connections
+void ControlServer::stop()
+{
+	io.stop();
+	if (io_thread.joinable())
+		io_thread.join();
+
+	// The IO thread has exited, so the sessions can be closed from this thread
+	for (auto &weak : sessions)
+	{
+		std::shared_ptr<ControlSession> session = weak.lock();
+		if (session)
+			session->close();
+	}
+	sessions.clear();
+
+	if (acceptor)
+	{
+		acceptor.reset();
+#ifdef CONTROL_LOCAL_SOCKET
+		std::remove(socket_path.c_str());
+#endif
+	}
+}
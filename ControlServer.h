@@ -0,0 +1,150 @@
+/**
+  C++ Multithreaded Periodic Task Scheduler
+
+  ControlServer.h
+
+  Purpose:
+  Header file for the local control socket used to add, update and delete tasks
+
+  The socket is a Unix domain socket where Boost.Asio supports them. On other
+  platforms (Windows with Boost 1.64), or when built with CONTROL_USE_TCP
+  defined, it is a TCP socket listening on the loopback interface only.
+
+  Requests and responses are length-prefixed binary frames, all integers
+  little-endian:
+
+	request:  u32 length | u8 op | u32 request id | payload
+	  OP_ADD     payload: u8 task type | u32 interval [| u8 NUMA node, 0xFF for any]
+	  OP_UPDATE  payload: u32 task uid | u32 interval
+	  OP_DELETE  payload: u32 task uid
+	response: u32 length | u8 status | u32 request id | u32 task uid
+
+  where length counts the bytes following it. Clients may pipeline any
+  number of requests without waiting; responses come back in request order.
+  Updates and deletes of tasks that don't exist are answered with
+  STATUS_UNKNOWN_TASK and have no effect.
+
+  @version 1.0 10/18/2026
+*/
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <boost\asio.hpp>
+#include "PeriodicScheduler.h"
+
+#if defined(BOOST_ASIO_HAS_LOCAL_SOCKETS) && !defined(CONTROL_USE_TCP)
+#define CONTROL_LOCAL_SOCKET
+typedef boost::asio::local::stream_protocol control_protocol;
+#else
+typedef boost::asio::ip::tcp control_protocol;
+#endif
+
+// Control request operations
+const std::uint8_t OP_ADD = 1;
+const std::uint8_t OP_UPDATE = 2;
+const std::uint8_t OP_DELETE = 3;
+
+// Control response status codes
+const std::uint8_t STATUS_OK = 0;
+const std::uint8_t STATUS_MALFORMED = 1;
+const std::uint8_t STATUS_UNKNOWN_TYPE = 2;
+const std::uint8_t STATUS_BAD_INTERVAL = 3;
+const std::uint8_t STATUS_UNKNOWN_TASK = 4;
+
+// Returned by ControlServer::process when the byte stream is not made of valid frames
+const std::size_t PROTOCOL_ERROR = (std::size_t)-1;
+
+/**
+	TaskType Structure, a kind of task that can be added over the control socket
+
+	@member name Task name
+	@member func Block of code that the task executes
+*/
+struct TaskType
+{
+	std::string name;
+	boost::function<void()> func;
+};
+
+class ControlSession;
+
+/**
+	ControlServer
+
+	Serves the control protocol on a local socket from its own thread,
+	off the path of the scheduler workers. All complete requests received in
+	one read are applied to the scheduler as a batch.
+
+	@member scheduler Scheduler the requests are applied to
+	@member socket_path Path of the Unix domain socket
+	@member port Loopback TCP port used where Unix domain sockets are not available
+	@member task_types Task types that can be added, by type number
+	@member io IO service running the socket
+	@member acceptor Acceptor listening on the socket
+	@member accept_retry Timer re-arming the acceptor after a failed accept
+	@member sessions Client connections, closed when the server stops
+	@member io_thread Thread running the IO service
+*/
+class ControlServer
+{
+private:
+	PeriodicScheduler &scheduler;
+	std::string socket_path;
+	unsigned short port;
+	std::unordered_map<std::uint8_t, TaskType> task_types;
+	boost::asio::io_service io;
+	std::unique_ptr<control_protocol::acceptor> acceptor;
+	boost::asio::steady_timer accept_retry;
+	std::vector<std::weak_ptr<ControlSession>> sessions;
+	boost::thread io_thread;
+
+	// Accepts the next client connection
+	void accept();
+
+public:
+	/**
+	  ControlServer Constructor
+
+	  @param s Scheduler the requests are applied to
+	  @param path Path of the Unix domain socket
+	  @param p Loopback TCP port used where Unix domain sockets are not available
+	*/
+	ControlServer(PeriodicScheduler &s, const std::string &path, unsigned short p);
+
+	// Stops the server
+	~ControlServer();
+
+	/**
+	  Registers a task type that OP_ADD requests can refer to. Must be called before start.
+
+	  @param type Task type number
+	  @param name Task name
+	  @param func Block of code that the task executes
+	*/
+	void register_task_type(std::uint8_t type, const std::string &name, boost::function<void()> func);
+
+	/**
+	  Starts listening on the socket in a new thread
+
+	  @return returns 1 if successfull else 0
+	*/
+	int start();
+
+	/**
+	  Stops listening and closes all client connections
+	*/
+	void stop();
+
+	/**
+	  Applies all complete request frames in a buffer to the scheduler as one batch
+
+	  @param data Received bytes
+	  @param size Number of received bytes
+	  @param responses Buffer the response frames are appended to
+	  @return Number of bytes consumed, PROTOCOL_ERROR if a frame has an invalid length.
+		The frames before an invalid one are still applied and acknowledged.
+	*/
+	std::size_t process(const std::uint8_t *data, std::size_t size, std::vector<std::uint8_t> &responses);
+};
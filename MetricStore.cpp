@@ -0,0 +1,98 @@
+/**
+  C++ Multithreaded Periodic Task Scheduler
+
+  MetricStore.cpp
+
+  Purpose:
+  Member function implementations of MetricStore and SqliteMetricStore
+
+  @version 1.0 10/18/2026
+*/
+#include <iostream>
+#include <sstream>
+#include <limits>
+#include "MetricStore.h"
+#include "ConnectionManager.h"
+#include "task_sqlite.h"
+
+// Formats a value for an SQL statement without rounding it, unlike std::to_string
+static std::string format_value(double value)
+{
+	std::ostringstream out;
+	out.precision(std::numeric_limits<double>::max_digits10);
+	out << value;
+	return out.str();
+}
+
+// Gets the aggregates of each metric one after the other
+int MetricStore::snapshot_aggregates(const std::vector<std::string> &metrics, std::vector<Aggregates> &aggs)
+{
+	aggs.assign(metrics.size(), Aggregates());
+	for (std::size_t i = 0; i < metrics.size(); i++)
+	{
+		if (!get_aggregates(metrics[i], aggs[i]))
+			return 0;
+	}
+	return 1;
+}
+
+// SqliteMetricStore constructor
+SqliteMetricStore::SqliteMetricStore(const std::string &file, ConnectionManager &manager)
+	:db_file(file),
+	connections(manager)
+{}
+
+// Inserts the sample into the metric table, which also refreshes the AGGREGATES table
+int SqliteMetricStore::insert(const std::string &metric, double value)
+{
+	std::unique_lock<std::mutex> lock;
+	sqlite3 *db = connections.acquire_writer(lock);
+
+	// Sample and aggregates are committed together so readers never see one without the other
+	if (!execute_statement(db, "BEGIN IMMEDIATE"))
+		return 0;
+
+	if (!insert_into_table(const_cast<char *>(db_file.c_str()), db, value, const_cast<char *>(metric.c_str())))
+	{
+		execute_statement(db, "ROLLBACK");
+		return 0;
+	}
+	return execute_statement(db, "COMMIT");
+}
+
+// Inserts the sample into the metric table and replaces the row of the metric in the AGGREGATES table.
+// The metric tables keep samples in insertion order and have no time column, so the time is not stored.
+int SqliteMetricStore::insert_sample(const std::string &metric, const std::chrono::system_clock::time_point &, double value, const Aggregates &agg)
+{
+	std::unique_lock<std::mutex> lock;
+	sqlite3 *db = connections.acquire_writer(lock);
+
+	// One transaction, like insert, so readers never see the sample without its aggregates
+	if (!execute_statement(db, "BEGIN IMMEDIATE"))
+		return 0;
+
+	if (!insert_value(const_cast<char *>(db_file.c_str()), db, value, const_cast<char *>(metric.c_str()))
+		|| !insert_aggregates(const_cast<char *>(db_file.c_str()), db, format_value(agg.avg()), format_value(agg.min), format_value(agg.max), const_cast<char *>(metric.c_str())))
+	{
+		execute_statement(db, "ROLLBACK");
+		return 0;
+	}
+	return execute_statement(db, "COMMIT");
+}
+
+// Gets count, sum, minimum and maximum of all the samples in the metric table
+int SqliteMetricStore::get_aggregates(const std::string &metric, Aggregates &agg)
+{
+	std::vector<Aggregates> aggs;
+
+	if (!connections.snapshot_aggregates(std::vector<std::string>(1, metric), aggs))
+		return 0;
+	agg = aggs[0];
+	return 1;
+}
+
+// Gets the aggregates of all metrics from one read transaction
+int SqliteMetricStore::snapshot_aggregates(const std::vector<std::string> &metrics, std::vector<Aggregates> &aggs)
+{
+	return connections.snapshot_aggregates(metrics, aggs);
+}
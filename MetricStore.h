@@ -0,0 +1,128 @@
+/**
+  C++ Multithreaded Periodic Task Scheduler
+
+  MetricStore.h
+
+  Purpose:
+  Header file for the pluggable metric storage interface and its SQLite backend
+
+  @version 1.0 10/18/2026
+*/
+#pragma once
+#include <sqlite3.h>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <chrono>
+
+class ConnectionManager;
+
+/**
+	Aggregates Structure
+
+	@member count Number of samples aggregated
+	@member sum Sum of all sample values
+	@member min Minimum sample value
+	@member max Maximum sample value
+*/
+struct Aggregates
+{
+	std::uint64_t count = 0;
+	double sum = 0;
+	double min = 0;
+	double max = 0;
+
+	// Average of all sample values, 0 if no samples were aggregated
+	double avg() const
+	{
+		return count ? sum / count : 0;
+	}
+};
+
+/**
+	MetricStore
+
+	Storage backend interface that task output is written to. Each metric
+	is identified by name and holds a series of decimal samples.
+*/
+class MetricStore
+{
+public:
+	virtual ~MetricStore()
+	{}
+
+	/**
+	  Stores a new sample of a metric and keeps its aggregates up-to-date
+
+	  @param metric Metric name
+	  @param value Sample value
+	  @return returns 1 if successfull else 0
+	*/
+	virtual int insert(const std::string &metric, double value) = 0;
+
+	/**
+	  Stores a sample taken earlier along with the aggregates of its metric
+	  computed outside the store. Sample and aggregates are written together.
+
+	  @param metric Metric name
+	  @param time Time the sample was taken
+	  @param value Sample value
+	  @param agg Aggregates of the metric including this sample
+	  @return returns 1 if successfull else 0
+	*/
+	virtual int insert_sample(const std::string &metric, const std::chrono::system_clock::time_point &time, double value, const Aggregates &agg) = 0;
+
+	/**
+	  Gets the aggregates over all samples of a metric
+
+	  @param metric Metric name
+	  @param agg Aggregates of the metric
+	  @return returns 1 if successfull else 0
+	*/
+	virtual int get_aggregates(const std::string &metric, Aggregates &agg) = 0;
+
+	/**
+	  Gets the aggregates of several metrics, read from a consistent snapshot
+	  where the backend supports it
+
+	  @param metrics Metric names
+	  @param aggs Aggregates of each metric, in the same order as metrics
+	  @return returns 1 if successfull else 0
+	*/
+	virtual int snapshot_aggregates(const std::vector<std::string> &metrics, std::vector<Aggregates> &aggs);
+};
+
+/**
+	SqliteMetricStore
+
+	Default MetricStore backend which keeps one row per sample in a task
+	specific table and the aggregates in the AGGREGATES table. Inserts go
+	through the single writer connection, queries through the calling
+	thread's reader connection.
+
+	@member db_file Database file name
+	@member connections Connection manager of the database
+*/
+class SqliteMetricStore : public MetricStore
+{
+private:
+	std::string db_file;
+	ConnectionManager &connections;
+
+public:
+	/**
+	  SqliteMetricStore Constructor
+
+	  @param file Database file name
+	  @param manager Connection manager of the opened database
+	*/
+	SqliteMetricStore(const std::string &file, ConnectionManager &manager);
+
+	int insert(const std::string &metric, double value) override;
+
+	int insert_sample(const std::string &metric, const std::chrono::system_clock::time_point &time, double value, const Aggregates &agg) override;
+
+	int get_aggregates(const std::string &metric, Aggregates &agg) override;
+
+	int snapshot_aggregates(const std::vector<std::string> &metrics, std::vector<Aggregates> &aggs) override;
+};
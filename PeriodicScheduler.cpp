@@ -11,16 +11,55 @@
 */
 #include "PeriodicScheduler.h"
 #include <ctime>
+#include <cstdio>
 #include <stdlib.h>
 #include <string>
 #include <iomanip>
 #include <atomic>
 #include <chrono>
+#include <sstream>
+#include <algorithm>
+
+// Period at which the worker pool is measured and resized
+const std::chrono::milliseconds SAMPLE_PERIOD(1000);
+
+// Firing lateness above which the pool is under pressure
+const std::chrono::milliseconds GROW_LATENESS(250);
+
+// Firing lateness below which spare workers may be retired
+const std::chrono::milliseconds SHRINK_LATENESS(20);
+
+// Time a worker may spend executing one task before it counts as blocked
+const std::chrono::seconds BLOCKED_THRESHOLD(5);
+
+// Consecutive samples needed before the pool grows or shrinks
+const unsigned GROW_SAMPLES = 2;
+const unsigned SHRINK_SAMPLES = 10;
+
+// Number of pool size changes kept in the stats
+const std::size_t RESIZE_HISTORY = 16;
 
 // PeriodicScheduler default constructor
 PeriodicScheduler::PeriodicScheduler()
+	:PeriodicScheduler(2, 15)
 {}
 
+// PeriodicScheduler constructor with the bounds of the worker pool
+PeriodicScheduler::PeriodicScheduler(unsigned min, unsigned max)
+	:PeriodicScheduler(SystemClock::instance(), min, max)
+{}
+
+// PeriodicScheduler constructor with the clock and the bounds of the worker pool
+PeriodicScheduler::PeriodicScheduler(Clock &c, unsigned min, unsigned max)
+	:min_workers(std::max(min, 1u)),
+	max_workers(std::max(min, max)),
+	clock(&c)
+{
+	stats = SchedulerStats();
+	stats.min_workers = min_workers;
+	stats.max_workers = max_workers;
+}
+
 // Generate a unique id for each task
 int PeriodicScheduler::getUid()
 {
@@ -29,92 +68,299 @@ int PeriodicScheduler::getUid()
 }
 
 // Schedules task in the priority queue based on the start time
-void PeriodicScheduler::schedule_periodic(const std::uint32_t &id, std::string const& n, std::function<void()> f, const std::chrono::system_clock::time_point &tp, const int &s)
+void PeriodicScheduler::schedule_periodic(const std::uint32_t &id, std::string const& n, std::function<void()> f, const std::chrono::system_clock::time_point &tp, const int &s, const int &node)
 {
 	// Create Task object
 	Task T(id, n, f, tp, std::chrono::seconds(s));
+	T.node = node;
 	{
 		// Acquire lock to push task to priority queue
 		std::unique_lock<std::mutex> lock(queue_mutex);
-		task_queue.push(T);
+		live_tasks.insert(id);
+		push_task(T);
 	}
-	// Notify a waiting thread that a task has been pushed to the queue
-	task_queue_changed.notify_one();
+	// Notify a waiting thread that a task has been pushed to the queue, a pinned
+	// task may only be picked up by its node's workers so all of them are woken
+	if (node < 0)
+		task_queue_changed.notify_one();
+	else
+		task_queue_changed.notify_all();
 }
 
 // Function that starts executing tasks
-void PeriodicScheduler::execute_tasks()
+void PeriodicScheduler::execute_tasks(int node, std::vector<int> cpus)
 {
+	boost::thread::id worker = boost::this_thread::get_id();
+
+	// The last worker of a node stays so that the node's pinned tasks keep running
+	auto can_retire = [this, node] { return retire_requests > 0 && (node < 0 || node_workers[node] > 1); };
+
+	// Keep the worker on its CPUs so that the data of its node's tasks stays in its caches and memory
+	if (!cpus.empty())
+		pin_current_thread(cpus);
+
 	while (executing)
 	{
 		Task task;
-		auto now = std::chrono::system_clock::now();
 		{
-			// Acquire lock to check the task queue for any task
+			// Acquire lock to check the task queues for any task
 			std::unique_lock<std::mutex> lock(queue_mutex);
-			if (task_queue.empty() && executing)
+
+			// Exit if the pool is being shrunk, only checked between tasks so nothing in flight is dropped
+			if (can_retire())
+			{
+				retire_requests--;
+				worker_count--;
+				if (node >= 0)
+					node_workers[node]--;
+
+				// Free the worker's CPU so that the next worker of the node is pinned to it
+				if (node >= 0 && affinity == AFFINITY_CPU && cpus.size() == 1)
+				{
+					auto cpu = std::find(nodes[node].begin(), nodes[node].end(), cpus[0]);
+					if (cpu != nodes[node].end())
+						cpu_workers[node][cpu - nodes[node].begin()]--;
+				}
+
+				// The supervisor joins the thread once it has exited
+				exited_workers.push_back(worker);
+				workers_idle.notify_one();
+				return;
+			}
+
+			TaskQueue *queue = worker_queue(node);
+			if (!queue)
 			{
 				// If no task in queue then wait for a task to be posted to the queue
-				while (task_queue.empty() && executing) {
+				idle_workers++;
+				workers_idle.notify_one();
+				// A worker that can't take a retirement request keeps waiting rather than spinning on it
+				while (!worker_queue(node) && executing && !can_retire()) {
 
 					//Wait untill task queue is changed and thread is notified
 					task_queue_changed.wait(lock);
 				}
+				idle_workers--;
+				continue;
 			}
-			// If task queue is not empty and the its time to execute the task
-			if (!task_queue.empty() && task_queue.top().time <= now)
+
+			// If it is not yet time to execute the earliest task, wait until it is due or the queue changes
+			auto now = clock->now();
+			if (queue->top().time > now)
 			{
+				// The deadline is copied out, the queue may change while the lock is released
+				auto due = queue->top().time;
+				idle_workers++;
+				workers_idle.notify_one();
+				clock->wait_until(task_queue_changed, lock, due);
+				idle_workers--;
+				continue;
+			}
 
-				task = task_queue.top();
-				task_queue.pop();
+			// The top is moved out rather than copied since it is popped right away
+			task = std::move(const_cast<Task &>(queue->top()));
+			queue->pop();
+			if (!prepare_task(task, now))
+				continue;
 
-				// Unlocks so that task can be executed
-				lock.unlock();
+			// Measure how late the task fires for the pool supervisor
+			auto lateness = now - task.time;
+			fired++;
+			lateness_total += lateness;
+			lateness_max = std::max(lateness_max, lateness);
+			running[worker] = now;
+		}
+		if (task.node < 0)
+			task_queue_changed.notify_one();
+		else
+			task_queue_changed.notify_all();
 
-				// Check if task is supposed to be deleted
-				if (delete_task_set.find(task.uid) == delete_task_set.end())
-				{
-					// Check if task is supposed to be updated
-					auto search = update_task_set.find(task.uid);
-
-					// Schedule task with the same interval
-					if (search == update_task_set.end())
-					{
-						schedule_periodic(task.uid, task.name, task.func, std::chrono::system_clock::now() + task.interval, task.interval.count());
-					}
-					else
-					{
-						// Schedule task with the new interval
-						schedule_periodic(task.uid, task.name, task.func, std::chrono::system_clock::now() + search->second, search->second.count());
-						std::unique_lock<std::mutex> lock(queue_mutex);
-
-						// Remove from to be update list once updated
-						update_task_set.erase(search);
-
-					}
-					// Execute the task
-					task.func();
-				}
-				else
-				{	
-					// Neither executes nor schedules the deleted task further
-					std::unique_lock<std::mutex> lock(queue_mutex);
+		// Execute the task
+		task.func();
 
-					// Remove task from to be deleted list once deleted
-					delete_task_set.erase(task.uid);
-				}
-			}
-		}
+		std::unique_lock<std::mutex> lock(queue_mutex);
+		running.erase(worker);
 	}
 	return;
 }
 
+// Pushes a task to the queue of its node with the next sequence number
+void PeriodicScheduler::push_task(Task task)
+{
+	task.seq = next_seq++;
+
+	// Node hints are ignored unless workers are grouped by node and the node has workers
+	if (task.node >= 0 && (std::size_t)task.node < node_queues.size() && !nodes[task.node].empty())
+		node_queues[task.node].push(std::move(task));
+	else
+		task_queue.push(std::move(task));
+}
+
+// Returns the queue holding the earliest task a worker of the node may execute
+TaskQueue *PeriodicScheduler::worker_queue(int node)
+{
+	TaskQueue *queue = task_queue.empty() ? NULL : &task_queue;
+
+	if (node >= 0 && !node_queues[node].empty())
+	{
+		if (!queue || TimeComparator()(task_queue.top(), node_queues[node].top()))
+			queue = &node_queues[node];
+	}
+	return queue;
+}
+
+// Returns the queue holding the earliest task of all queues
+TaskQueue *PeriodicScheduler::earliest_queue()
+{
+	TaskQueue *queue = worker_queue(-1);
+
+	for (auto &node_queue : node_queues)
+	{
+		if (!node_queue.empty() && (!queue || TimeComparator()(queue->top(), node_queue.top())))
+			queue = &node_queue;
+	}
+	return queue;
+}
+
+// Number of tasks in all queues
+std::size_t PeriodicScheduler::queued_tasks() const
+{
+	std::size_t count = task_queue.size();
+
+	for (auto &node_queue : node_queues)
+		count += node_queue.size();
+	return count;
+}
+
+// Starts a new worker on the node with the fewest workers
+void PeriodicScheduler::start_worker(boost::thread_group &workers)
+{
+	boost::thread *thread;
+	int node = -1;
+
+	// Nodes without CPUs the process may run on get no workers
+	for (std::size_t i = 0; i < nodes.size(); i++)
+	{
+		if (!nodes[i].empty() && (node < 0 || node_workers[i] < node_workers[node]))
+			node = (int)i;
+	}
+
+	if (affinity == AFFINITY_NONE || node < 0)
+	{
+		thread = workers.create_thread(boost::bind(&PeriodicScheduler::execute_tasks, this, -1, std::vector<int>()));
+		worker_threads[thread->get_id()] = thread;
+		return;
+	}
+
+	std::vector<int> cpus = nodes[node];
+
+	// Spread the workers of a node over its CPUs, taking the CPU with the fewest workers so
+	// that CPUs freed by retired workers are used again before any CPU gets a second worker
+	if (affinity == AFFINITY_CPU)
+	{
+		std::size_t cpu = std::min_element(cpu_workers[node].begin(), cpu_workers[node].end()) - cpu_workers[node].begin();
+		cpu_workers[node][cpu]++;
+		cpus = std::vector<int>(1, nodes[node][cpu]);
+	}
+
+	node_workers[node]++;
+	thread = workers.create_thread(boost::bind(&PeriodicScheduler::execute_tasks, this, node, cpus));
+	worker_threads[thread->get_id()] = thread;
+}
+
+// Joins the workers that retired, so that their threads don't stay around for the life of the scheduler
+void PeriodicScheduler::reap_workers(boost::thread_group &workers)
+{
+	for (auto &id : exited_workers)
+	{
+		auto search = worker_threads.find(id);
+		if (search == worker_threads.end())
+			continue;
+
+		// The worker no longer touches the queue once it is in exited_workers, so it can be joined under the lock
+		boost::thread *thread = search->second;
+		workers.remove_thread(thread);
+		thread->join();
+		delete thread;
+		worker_threads.erase(search);
+	}
+	exited_workers.clear();
+}
+
+// Sets how workers are placed on CPUs
+void PeriodicScheduler::set_affinity(AffinityMode mode)
+{
+	std::unique_lock<std::mutex> lock(queue_mutex);
+
+	affinity = mode;
+	nodes.clear();
+	if (mode != AFFINITY_NONE)
+		nodes = get_numa_nodes();
+
+	// Tasks already queued keep their place, new queues only receive tasks pushed from now on
+	node_queues.resize(nodes.size());
+	node_workers.assign(nodes.size(), 0);
+	cpu_workers.clear();
+	for (auto &cpus : nodes)
+		cpu_workers.push_back(std::vector<unsigned>(cpus.size(), 0));
+
+	// Every node with CPUs needs a worker for its pinned tasks
+	unsigned worker_nodes = (unsigned)std::count_if(nodes.begin(), nodes.end(), [](const std::vector<int> &cpus) { return !cpus.empty(); });
+	min_workers = std::max(min_workers, worker_nodes);
+	max_workers = std::max(max_workers, min_workers);
+	stats.min_workers = min_workers;
+	stats.max_workers = max_workers;
+}
+
+// Returns the number of NUMA nodes workers are grouped by
+std::size_t PeriodicScheduler::get_node_count()
+{
+	std::unique_lock<std::mutex> lock(queue_mutex);
+	return nodes.size();
+}
+
+// Applies pending deletes and updates to a task taken off the queue and queues its next run
+bool PeriodicScheduler::prepare_task(Task &task, const std::chrono::system_clock::time_point &now)
+{
+	// Neither executes nor schedules the deleted task further
+	auto deleted = delete_task_set.find(task.uid);
+	if (deleted != delete_task_set.end())
+	{
+		// Remove task from to be deleted list once deleted
+		delete_task_set.erase(deleted);
+		return false;
+	}
+
+	// Check if task is supposed to be updated
+	auto search = update_task_set.find(task.uid);
+	if (search != update_task_set.end())
+	{
+		task.interval = search->second;
+
+		// Remove from to be update list once updated
+		update_task_set.erase(search);
+	}
+
+	// Schedule the next run of the task with its current interval, copying the task
+	// rather than constructing a new one so that func is not wrapped once more every run
+	Task next = task;
+	next.time = now + task.interval;
+	push_task(std::move(next));
+	return true;
+}
+
 // Display a list of task currently queued
 void PeriodicScheduler::get_tasks_overview()
 {
-	// Acquire a lock to duplicate the queue since priority queues can't be traversed
+	// Acquire a lock to duplicate the queues since priority queues can't be traversed
 	std::unique_lock<std::mutex> lock(queue_mutex);
-	std::priority_queue<Task, std::deque<Task>, TimeComparator> temp = task_queue;
+	TaskQueue temp = task_queue;
+	for (auto &node_queue : node_queues)
+	{
+		TaskQueue node_temp = node_queue;
+		for (; !node_temp.empty(); node_temp.pop())
+			temp.push(node_temp.top());
+	}
 
 	// Release lock after duplicating
 	lock.unlock();
@@ -139,34 +385,327 @@ std::time_t PeriodicScheduler::get_time_to_print(const std::chrono::system_clock
 	return time_c;
 }
 
+// Schedules several tasks with a single acquisition of the queue lock
+void PeriodicScheduler::schedule_batch(const std::vector<Task> &tasks)
+{
+	if (tasks.empty())
+		return;
+	{
+		std::unique_lock<std::mutex> lock(queue_mutex);
+		for (auto &task : tasks)
+		{
+			live_tasks.insert(task.uid);
+			push_task(task);
+		}
+	}
+	task_queue_changed.notify_all();
+}
+
 // Adds the task ID to delete set so that the task is deleted
-void PeriodicScheduler::delete_task(const std::uint32_t &task_id)
+int PeriodicScheduler::delete_task(const std::uint32_t &task_id)
 {
-	delete_task_set.insert(task_id);
+	std::vector<int> found;
+	delete_tasks(std::vector<std::uint32_t>(1, task_id), found);
+	return found[0];
+}
+
+// Adds several task IDs to delete set, only tasks that exist are recorded so the set stays bounded by the queued tasks
+void PeriodicScheduler::delete_tasks(const std::vector<std::uint32_t> &task_ids, std::vector<int> &found)
+{
+	found.assign(task_ids.size(), 0);
+	if (task_ids.empty())
+		return;
+
+	std::unique_lock<std::mutex> lock(queue_mutex);
+	for (std::size_t i = 0; i < task_ids.size(); i++)
+	{
+		// The task leaves live_tasks right away, its queue entry is dropped when it is next due
+		if (live_tasks.erase(task_ids[i]))
+		{
+			delete_task_set.insert(task_ids[i]);
+			update_task_set.erase(task_ids[i]);
+			found[i] = 1;
+		}
+	}
 }
 
 // Adds the task ID to update set to update the tasks
-void PeriodicScheduler::update_task(const std::uint32_t &task_id, const int &sec)
+int PeriodicScheduler::update_task(const std::uint32_t &task_id, const int &sec)
+{
+	std::vector<int> found;
+	update_tasks(std::vector<std::pair<std::uint32_t, int>>(1, std::make_pair(task_id, sec)), found);
+	return found[0];
+}
+
+// Adds several task IDs and their new intervals to update set, tasks that don't exist are ignored
+void PeriodicScheduler::update_tasks(const std::vector<std::pair<std::uint32_t, int>> &updates, std::vector<int> &found)
+{
+	found.assign(updates.size(), 0);
+	if (updates.empty())
+		return;
+
+	std::unique_lock<std::mutex> lock(queue_mutex);
+	for (std::size_t i = 0; i < updates.size(); i++)
+	{
+		if (live_tasks.count(updates[i].first))
+		{
+			update_task_set[updates[i].first] = std::chrono::seconds(updates[i].second);
+			found[i] = 1;
+		}
+	}
+}
+
+// Measures the pool over the last sampling period and grows or shrinks it
+void PeriodicScheduler::resize_pool(boost::thread_group &workers)
+{
+	auto now = clock->now();
+
+	// Workers stuck on a single task do not pick up due tasks
+	unsigned blocked = 0;
+	for (auto &r : running)
+	{
+		if (now - r.second > BLOCKED_THRESHOLD)
+			blocked++;
+	}
+
+	// A due task no worker got to yet is late as well
+	auto max_lateness = lateness_max;
+	TaskQueue *earliest = earliest_queue();
+	if (earliest && earliest->top().time < now)
+		max_lateness = std::max(max_lateness, now - earliest->top().time);
+	auto avg_lateness = fired ? lateness_total / (std::int64_t)fired : std::chrono::system_clock::duration::zero();
+
+	// Separate thresholds and streak lengths for growing and shrinking keep the pool from flapping
+	bool pressure = max_lateness > GROW_LATENESS || (blocked > 0 && idle_workers == 0);
+	bool spare = !pressure && max_lateness < SHRINK_LATENESS && idle_workers > 1;
+	grow_streak = pressure ? grow_streak + 1 : 0;
+	shrink_streak = spare ? shrink_streak + 1 : 0;
+
+	// Workers asked to retire no longer count towards the pool size
+	unsigned current = worker_count - retire_requests;
+	unsigned target = current;
+	if (grow_streak >= GROW_SAMPLES && current < max_workers)
+	{
+		// Make up for every blocked worker, at least one
+		target = std::min(max_workers, current + std::max(blocked, 1u));
+	}
+	else if (shrink_streak >= SHRINK_SAMPLES && current > min_workers)
+	{
+		target = current - 1;
+	}
+
+	if (target != current)
+	{
+		std::ostringstream reason;
+		reason << "max lateness " << std::chrono::duration_cast<std::chrono::milliseconds>(max_lateness).count() << " ms, "
+			<< idle_workers << " idle, " << blocked << " blocked, " << queued_tasks() << " queued";
+
+		ResizeEvent event = { now, current, target, reason.str() };
+		stats.resizes.push_back(event);
+		if (stats.resizes.size() > RESIZE_HISTORY)
+			stats.resizes.pop_front();
+
+		if (target > current)
+		{
+			// Cancel pending retirements before starting new threads
+			unsigned added = target - current;
+			unsigned cancelled = std::min(retire_requests, added);
+			retire_requests -= cancelled;
+			for (unsigned i = cancelled; i < added; i++, worker_count++)
+				start_worker(workers);
+		}
+		else
+		{
+			// Idle workers are woken up to retire, busy ones retire after their current task.
+			// worker_count only drops once a worker has actually exited.
+			retire_requests += current - target;
+			task_queue_changed.notify_all();
+		}
+		grow_streak = 0;
+		shrink_streak = 0;
+	}
+
+	stats.workers = worker_count;
+	stats.idle_workers = idle_workers;
+	stats.blocked_workers = blocked;
+	stats.queue_depth = queued_tasks();
+	stats.node_workers = node_workers;
+	stats.avg_lateness = std::chrono::duration_cast<std::chrono::milliseconds>(avg_lateness);
+	stats.max_lateness = std::chrono::duration_cast<std::chrono::milliseconds>(max_lateness);
+
+	// Start a new sampling period
+	fired = 0;
+	lateness_total = std::chrono::system_clock::duration::zero();
+	lateness_max = std::chrono::system_clock::duration::zero();
+}
+
+// Checks whether every worker is waiting and no task is due
+bool PeriodicScheduler::pool_idle()
 {
-	update_task_set[task_id] = std::chrono::seconds(sec);
+	// Started threads count as busy until they first wait, retired ones no longer count
+	if (idle_workers < worker_threads.size() - exited_workers.size())
+		return false;
+
+	TaskQueue *earliest = earliest_queue();
+	return !earliest || earliest->top().time > clock->now();
+}
+
+// Returns a snapshot of the worker pool
+SchedulerStats PeriodicScheduler::get_stats()
+{
+	std::unique_lock<std::mutex> lock(queue_mutex);
+	SchedulerStats snapshot = stats;
+
+	// Pool size and queue depth are reported as of now, measurements as of the last sample
+	snapshot.workers = worker_count;
+	snapshot.idle_workers = idle_workers;
+	snapshot.queue_depth = queued_tasks();
+	snapshot.node_workers = node_workers;
+	return snapshot;
+}
+
+// Displays the worker pool statistics
+void PeriodicScheduler::get_stats_overview()
+{
+	SchedulerStats s = get_stats();
+
+	std::cout << "Workers: " << s.workers << " (min " << s.min_workers << ", max " << s.max_workers << "), "
+		<< s.idle_workers << " idle, " << s.blocked_workers << " blocked" << std::endl;
+	for (std::size_t node = 0; node < s.node_workers.size(); node++)
+		std::cout << "  NUMA node " << node << ": " << s.node_workers[node] << " workers" << std::endl;
+	std::cout << "Queued tasks: " << s.queue_depth << std::endl;
+	std::cout << "Lateness: avg " << s.avg_lateness.count() << " ms, max " << s.max_lateness.count() << " ms" << std::endl;
+	for (auto &event : s.resizes)
+	{
+		std::cout << "  " << event.from << " -> " << event.to << " workers: " << event.reason << std::endl;
+	}
 }
 
 // Runs the scheduler
 void PeriodicScheduler::run()
 {
+	// Nothing advances a simulated clock here, the workers would wait forever
+	if (dynamic_cast<SimulatedClock *>(clock))
+	{
+		fprintf(stderr, "A scheduler on a simulated clock must be run with run_simulation!\n");
+		return;
+	}
+
 	// Creates a Boost thread group
 	boost::thread_group microThreads;
 
-	// Create a pool of threads
-	for (int i = 0; i < 15; i++)
-		microThreads.create_thread(boost::bind(&PeriodicScheduler::execute_tasks, this));
+	{
+		std::unique_lock<std::mutex> lock(queue_mutex);
+
+		// Create the initial pool of threads
+		for (; worker_count < min_workers; worker_count++)
+			start_worker(microThreads);
+		stats.workers = worker_count;
+
+		// Resize the pool every sampling period until the scheduler is stopped
+		while (executing)
+		{
+			supervisor_wakeup.wait_for(lock, SAMPLE_PERIOD);
+			reap_workers(microThreads);
+			if (executing)
+				resize_pool(microThreads);
+		}
+	}
 
 	// Joins all thread at the end
 	microThreads.join_all();
+
+	std::unique_lock<std::mutex> lock(queue_mutex);
+	worker_threads.clear();
+	exited_workers.clear();
+	worker_count = 0;
+	retire_requests = 0;
+	node_workers.assign(nodes.size(), 0);
+	for (auto &counts : cpu_workers)
+		counts.assign(counts.size(), 0);
+}
+
+// Returns the clock the scheduler reads the time from
+Clock &PeriodicScheduler::get_clock()
+{
+	return *clock;
+}
+
+// Runs the scheduler in simulated time, advancing the clock whenever the workers have nothing left to run
+std::uint64_t PeriodicScheduler::run_simulation(SimulatedClock &sim, const std::chrono::system_clock::time_point &until)
+{
+	boost::thread_group microThreads;
+	std::uint64_t executed = 0;
+
+	if (&sim != clock)
+		return 0;
+
+	{
+		std::unique_lock<std::mutex> lock(queue_mutex);
+
+		for (; worker_count < min_workers; worker_count++)
+			start_worker(microThreads);
+		stats.workers = worker_count;
+
+		// The pool is measured and resized in simulated time as well
+		auto next_sample = sim.now() + SAMPLE_PERIOD;
+		while (executing)
+		{
+			// Every task due at the current time has to run first, including the ones it queues
+			while (executing && !pool_idle())
+				workers_idle.wait(lock);
+			reap_workers(microThreads);
+			if (!executing)
+				break;
+
+			TaskQueue *earliest = earliest_queue();
+			auto next = next_sample;
+			if (earliest && earliest->top().time < next)
+				next = earliest->top().time;
+			if (next > until)
+				break;
+
+			// Jump straight to the next deadline, so the tasks due then fire exactly on time
+			sim.advance_to(next);
+			if (next == next_sample)
+			{
+				executed += fired;
+				resize_pool(microThreads);
+				next_sample += SAMPLE_PERIOD;
+			}
+			task_queue_changed.notify_all();
+		}
+		executed += fired;
+		fired = 0;
+
+		// Stop the workers, the simulation ends like the scheduler is stopped
+		executing = false;
+	}
+	task_queue_changed.notify_all();
+	microThreads.join_all();
+
+	std::unique_lock<std::mutex> lock(queue_mutex);
+	worker_threads.clear();
+	exited_workers.clear();
+	worker_count = 0;
+	retire_requests = 0;
+	node_workers.assign(nodes.size(), 0);
+	for (auto &counts : cpu_workers)
+		counts.assign(counts.size(), 0);
+	sim.advance_to(until);
+	return executed;
 }
 
 // Stops the scheduler
 void PeriodicScheduler::stop()
 {
-	executing = false;
+	{
+		std::unique_lock<std::mutex> lock(queue_mutex);
+		executing = false;
+	}
+
+	// Wake up waiting workers and the supervisor so that they exit
+	task_queue_changed.notify_all();
+	supervisor_wakeup.notify_all();
+	workers_idle.notify_all();
 }
\ No newline at end of file
@@ -16,8 +16,12 @@
 #include <condition_variable>
 #include <unordered_set>
 #include <unordered_map>
+#include <map>
+#include <vector>
 #include <boost\thread.hpp>
 #include <boost\bind.hpp>
+#include "Clock.h"
+#include "Affinity.h"
 
 /**
 	Task Structure
@@ -27,6 +31,8 @@
 	@member interval Interval at which task is repeated
 	@member name Task name
 	@member uid Task ID
+	@member seq Order in which the task was queued, breaks ties between tasks due at the same time
+	@member node NUMA node whose workers should execute the task, -1 for any worker
 */
 struct Task
 {
@@ -35,6 +41,8 @@ struct Task
 	std::chrono::seconds interval;
 	std::string name;
 	std::uint32_t uid;
+	std::uint64_t seq = 0;
+	int node = -1;
 
 	// Default task constructor
 	Task()
@@ -64,39 +72,229 @@ struct Task
 	}
 };
 
-// Comparator to sort the priority queue
+// Comparator to sort the priority queue, tasks due at the same time run in the order they were queued
 struct TimeComparator
 {
 	bool operator()(const Task& lhs, const Task& rhs) const
 	{
-		return lhs.time > rhs.time;
+		if (lhs.time != rhs.time)
+			return lhs.time > rhs.time;
+		return lhs.seq > rhs.seq;
 	}
 };
 
+typedef std::priority_queue<Task, std::deque<Task>, TimeComparator> TaskQueue;
+
+/**
+	ResizeEvent Structure, records a change of the worker pool size
+
+	@member time Time of the change
+	@member from Pool size before the change
+	@member to Pool size after the change
+	@member reason Measurements that triggered the change
+*/
+struct ResizeEvent
+{
+	std::chrono::system_clock::time_point time;
+	unsigned from;
+	unsigned to;
+	std::string reason;
+};
+
+/**
+	SchedulerStats Structure, snapshot of the worker pool
+
+	@member workers Current number of worker threads, including the ones asked to retire
+	@member min_workers Lower bound of the pool size
+	@member max_workers Upper bound of the pool size
+	@member idle_workers Workers waiting for a task to be due
+	@member blocked_workers Workers executing the same task for longer than the blocked threshold
+	@member queue_depth Number of tasks in all task queues
+	@member node_workers Number of workers on each NUMA node, empty if workers are not grouped
+	@member avg_lateness Average firing lateness over the last sampling period
+	@member max_lateness Maximum firing lateness over the last sampling period
+	@member resizes Most recent pool size changes, oldest first
+*/
+struct SchedulerStats
+{
+	unsigned workers;
+	unsigned min_workers;
+	unsigned max_workers;
+	unsigned idle_workers;
+	unsigned blocked_workers;
+	std::size_t queue_depth;
+	std::vector<unsigned> node_workers;
+	std::chrono::milliseconds avg_lateness;
+	std::chrono::milliseconds max_lateness;
+	std::deque<ResizeEvent> resizes;
+};
+
 /**
 	PeriodicScheduler
 
-	@member task_queue Priority Queue to schedule tasks
+	@member task_queue Priority Queue to schedule tasks any worker may execute
+	@member node_queues Priority Queues of the tasks pinned to each NUMA node
 	@member task_queue_changed Condition Variable to notify threads when task queue is changed
 	@member queue_mutex Mutex to lock while reading or writing to task queue
 	@member delete_task_set Delete task set to delete tasks
 	@member update_task_set Update task set to update tasks
+	@member live_tasks IDs of the tasks that are scheduled and not deleted
 	@member executing Bool value to start or stop Scheduler
+	@member min_workers Lower bound of the worker pool size
+	@member max_workers Upper bound of the worker pool size
+	@member worker_count Number of running worker threads, including the ones asked to retire
+	@member idle_workers Number of workers waiting on task_queue_changed
+	@member retire_requests Number of workers asked to exit to shrink the pool
+	@member running Start time of the task each busy worker is executing
+	@member worker_threads Threads of the workers by thread ID
+	@member exited_workers Workers that retired and are waiting to be joined
+	@member fired Number of tasks fired in the current sampling period
+	@member lateness_total Sum of firing lateness in the current sampling period
+	@member lateness_max Maximum firing lateness in the current sampling period
+	@member grow_streak Consecutive samples in which the pool was under pressure
+	@member shrink_streak Consecutive samples in which the pool had spare workers
+	@member stats Pool snapshot taken at the last sample
+	@member supervisor_wakeup Condition Variable to wake the pool supervisor on stop
+	@member workers_idle Condition Variable to notify the simulation driver when a worker waits or retires
+	@member clock Clock the scheduler reads the time from
+	@member next_seq Sequence number given to the next queued task
+	@member affinity Placement of the workers on CPUs
+	@member nodes CPUs of each NUMA node
+	@member node_workers Number of workers on each NUMA node
+	@member cpu_workers Number of workers pinned to each CPU of each node in AFFINITY_CPU mode, in the order of nodes
 */
 class PeriodicScheduler
 {
 private:
-	std::priority_queue<Task, std::deque<Task>, TimeComparator> task_queue;
+	TaskQueue task_queue;
+	std::vector<TaskQueue> node_queues;
 	std::condition_variable task_queue_changed;
 	std::mutex queue_mutex;
 	std::unordered_set<std::uint32_t> delete_task_set;
 	std::unordered_map<std::uint32_t, std::chrono::seconds> update_task_set;
+	std::unordered_set<std::uint32_t> live_tasks;
 	bool executing = true;
 
+	unsigned min_workers;
+	unsigned max_workers;
+	unsigned worker_count = 0;
+	unsigned idle_workers = 0;
+	unsigned retire_requests = 0;
+	std::map<boost::thread::id, std::chrono::system_clock::time_point> running;
+	std::map<boost::thread::id, boost::thread *> worker_threads;
+	std::vector<boost::thread::id> exited_workers;
+	std::uint64_t fired = 0;
+	std::chrono::system_clock::duration lateness_total{ 0 };
+	std::chrono::system_clock::duration lateness_max{ 0 };
+	unsigned grow_streak = 0;
+	unsigned shrink_streak = 0;
+	SchedulerStats stats;
+	std::condition_variable supervisor_wakeup;
+	std::condition_variable workers_idle;
+	Clock *clock;
+	std::uint64_t next_seq = 0;
+	AffinityMode affinity = AFFINITY_NONE;
+	std::vector<std::vector<int>> nodes;
+	std::vector<unsigned> node_workers;
+	std::vector<std::vector<unsigned>> cpu_workers;
+
+	/**
+	  Returns the queue holding the earliest task a worker may execute.
+	  Must be called with queue_mutex held.
+
+	  @param node NUMA node of the worker, -1 for the shared queue only
+	  @return Queue whose top is the earliest task, NULL if there is none
+	*/
+	TaskQueue *worker_queue(int node);
+
+	/**
+	  Returns the queue holding the earliest task of all queues.
+	  Must be called with queue_mutex held.
+
+	  @return Queue whose top is the earliest task, NULL if there is none
+	*/
+	TaskQueue *earliest_queue();
+
+	// Number of tasks in all queues, must be called with queue_mutex held
+	std::size_t queued_tasks() const;
+
+	/**
+	  Starts a new worker on the NUMA node with CPUs that has the fewest workers.
+	  Must be called with queue_mutex held.
+
+	  @param workers Thread group the worker is added to
+	*/
+	void start_worker(boost::thread_group &workers);
+
+	/**
+	  Joins the workers that retired and removes them from the thread group.
+	  Must be called with queue_mutex held.
+
+	  @param workers Thread group of the workers
+	*/
+	void reap_workers(boost::thread_group &workers);
+
+	/**
+	  Pushes a task to the task queue. Must be called with queue_mutex held.
+
+	  @param task Task to queue
+	*/
+	void push_task(Task task);
+
+	/**
+	  Applies pending deletes and updates to a task taken off the queue and
+	  queues its next run. Must be called with queue_mutex held.
+
+	  @param task Task taken off the queue
+	  @param now Current time
+	  @return false if the task was deleted
+	*/
+	bool prepare_task(Task &task, const std::chrono::system_clock::time_point &now);
+
+	/**
+	  Measures the pool over the last sampling period and grows or shrinks it.
+	  Must be called with queue_mutex held.
+
+	  @param workers Thread group new workers are added to
+	*/
+	void resize_pool(boost::thread_group &workers);
+
+	/**
+	  Checks whether nothing more can run at the current time: every worker is waiting
+	  and no task is due. Must be called with queue_mutex held.
+
+	  @return true if the time can be advanced
+	*/
+	bool pool_idle();
+
 public:
-	// PeriodicScheduler constructor 
+	// PeriodicScheduler constructor, the pool grows between 2 and 15 workers
 	PeriodicScheduler();
 
+	/**
+	  PeriodicScheduler constructor
+
+	  @param min Minimum number of worker threads
+	  @param max Maximum number of worker threads
+	*/
+	PeriodicScheduler(unsigned min, unsigned max);
+
+	/**
+	  PeriodicScheduler constructor
+
+	  @param c Clock the scheduler reads the time from
+	  @param min Minimum number of worker threads
+	  @param max Maximum number of worker threads
+	*/
+	PeriodicScheduler(Clock &c, unsigned min, unsigned max);
+
+	/**
+	  Returns the clock the scheduler reads the time from
+
+	  @return Scheduler clock
+	*/
+	Clock &get_clock();
+
 	/**
 	  Generates a unique ID for each task
 
@@ -112,13 +310,38 @@ public:
 	  @param f void function that the task executes
 	  @param tp Timepoint at which the task is scheduled to be executed
 	  @param s Interval at which task is executed
+	  @param node NUMA node whose workers should execute the task, -1 for any worker
+	*/
+	void schedule_periodic(const std::uint32_t &id, std::string const& n, std::function<void()> f, const std::chrono::system_clock::time_point &tp, const int &s, const int &node = -1);
+
+	/**
+	  Schedules several tasks for execution at once
+
+	  @param tasks Tasks to schedule
 	*/
-	void schedule_periodic(const std::uint32_t &id, std::string const& n, std::function<void()> f, const std::chrono::system_clock::time_point &tp, const int &s);
+	void schedule_batch(const std::vector<Task> &tasks);
 
 	/**
 	  Function that executes task in a loop
+
+	  @param node NUMA node of the worker, -1 if workers are not grouped by node
+	  @param cpus CPUs the worker is pinned to, empty to leave it floating
+	*/
+	void execute_tasks(int node = -1, std::vector<int> cpus = std::vector<int>());
+
+	/**
+	  Sets how workers are placed on CPUs. Must be called before run.
+
+	  @param mode Worker placement
 	*/
-	void execute_tasks();
+	void set_affinity(AffinityMode mode);
+
+	/**
+	  Returns the number of NUMA nodes workers are grouped by
+
+	  @return Number of nodes, 0 if workers are not grouped
+	*/
+	std::size_t get_node_count();
 
 	/**
 	  Displays a list of task currently queued
@@ -137,22 +360,66 @@ public:
 	  Adds the task ID to delete set so that the task is deleted
 
 	  @param task_id Task ID
+	  @return returns 1 if the task exists else 0
+	*/
+	int delete_task(const std::uint32_t &task_id);
+
+	/**
+	  Adds several task IDs to delete set at once
+
+	  @param task_ids Task IDs
+	  @param found Set to 1 for each task that exists, 0 for the others, which are ignored
 	*/
-	void delete_task(const std::uint32_t &task_id);
+	void delete_tasks(const std::vector<std::uint32_t> &task_ids, std::vector<int> &found);
 
 	/**
 	  Adds the task ID to update set to update the task
 
 	  @param task_id Task ID
 	  @param sec New interval
+	  @return returns 1 if the task exists else 0
 	*/
-	void update_task(const std::uint32_t &task_id, const int &sec);
+	int update_task(const std::uint32_t &task_id, const int &sec);
 
 	/**
-	  Runs the scheduler
+	  Adds several task IDs to update set at once
+
+	  @param updates Pairs of task ID and new interval
+	  @param found Set to 1 for each task that exists, 0 for the others, which are ignored
+	*/
+	void update_tasks(const std::vector<std::pair<std::uint32_t, int>> &updates, std::vector<int> &found);
+
+	/**
+	  Returns a snapshot of the worker pool
+
+	  @return Pool size, measurements of the last sampling period and recent resizes
+	*/
+	SchedulerStats get_stats();
+
+	/**
+	  Displays the worker pool statistics
+	*/
+	void get_stats_overview();
+
+	/**
+	  Runs the scheduler. Starts min workers and supervises the pool size until stopped.
+	  A scheduler on a SimulatedClock is refused, nothing would advance its time.
 	*/
 	void run();
 
+	/**
+	  Runs the scheduler in simulated time. Starts min workers like run, and the calling
+	  thread advances the time straight to the next deadline or pool sample once every
+	  worker is waiting. Tasks fire exactly on time, and with a single worker they run in
+	  deadline and queue order, so the same schedule always runs the same way.
+	  The scheduler is stopped when it returns.
+
+	  @param sim Simulated clock, must be the clock the scheduler was constructed with
+	  @param until Simulated time point to stop at
+	  @return Number of tasks executed
+	*/
+	std::uint64_t run_simulation(SimulatedClock &sim, const std::chrono::system_clock::time_point &until);
+
 	/**
 	  Stops the scheduler
 	*/
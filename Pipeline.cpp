@@ -0,0 +1,162 @@
+/**
+  C++ Multithreaded Periodic Task Scheduler
+
+  Pipeline.cpp
+
+  Purpose:
+  Member function implementations of Pipeline, AggregateStage and PersistStage
+
+  @version 1.0 10/18/2026
+*/
+#include "Pipeline.h"
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+
+// Pipeline constructor
+Pipeline::Pipeline(std::size_t capacity)
+	:queue_capacity(capacity)
+{}
+
+// Stops the pipeline
+Pipeline::~Pipeline()
+{
+	stop();
+}
+
+// Adds a stage with its own input queue
+std::size_t Pipeline::add_stage(const std::string &name, StageFunc func, unsigned threads)
+{
+	stages.emplace_back(new Stage(name, func, std::max(threads, 1u), queue_capacity));
+	return stages.size() - 1;
+}
+
+// Passes the output of a stage to a later stage
+int Pipeline::connect(std::size_t from, std::size_t to)
+{
+	// Only connecting to later stages keeps the graph acyclic and lets stop() drain it in index order
+	if (from >= to || to >= stages.size() || running)
+		return 0;
+	stages[from]->next.push_back(to);
+	return 1;
+}
+
+// Starts the threads of all stages
+void Pipeline::start()
+{
+	if (running)
+		return;
+	running = true;
+
+	for (std::size_t i = 0; i < stages.size(); i++)
+	{
+		for (unsigned t = 0; t < stages[i]->thread_count; t++)
+			stages[i]->threads.create_thread(boost::bind(&Pipeline::execute_stage, this, i));
+	}
+}
+
+// Stops accepting samples and drains every stage in order
+void Pipeline::stop()
+{
+	if (!running)
+		return;
+	running = false;
+
+	// A stage is closed only after all stages feeding it have finished
+	for (auto &stage : stages)
+	{
+		stage->input.close();
+		stage->threads.join_all();
+	}
+}
+
+// Function that executes a stage in a loop until its input queue is closed
+void Pipeline::execute_stage(std::size_t index)
+{
+	Stage &stage = *stages[index];
+	Sample sample;
+
+	while (stage.input.pop(sample))
+	{
+		bool passed = stage.func(sample);
+		stage.processed++;
+		if (!passed)
+			continue;
+
+		// Waits while a next stage is full, which holds back this stage in turn
+		for (std::size_t next : stage.next)
+			stages[next]->input.push(sample);
+	}
+}
+
+// Submits a sample to a stage without waiting
+bool Pipeline::submit(std::size_t stage, const Sample &sample)
+{
+	if (stage >= stages.size())
+		return false;
+	if (stages[stage]->input.try_push(sample))
+		return true;
+	stages[stage]->rejected++;
+	return false;
+}
+
+// Displays queue depth, processed and rejected samples of each stage
+void Pipeline::get_stages_overview()
+{
+	std::cout << "+---------------------" << "+-----------" << "+-------------" << "+-------------+" << std::endl;
+	std::cout << "|" << std::setw(20) << "Stage" << " |" << std::setw(10) << "Queued" << " |" << std::setw(12) << "Processed" << " |" << std::setw(12) << "Rejected" << " |" << std::endl;
+	std::cout << "+---------------------" << "+-----------" << "+-------------" << "+-------------+" << std::endl;
+	for (auto &stage : stages)
+	{
+		std::cout << "|" << std::setw(20) << stage->name << " |" << std::setw(10) << stage->input.size() << " |" << std::setw(12) << stage->processed << " |" << std::setw(12) << stage->rejected << " |" << std::endl;
+		std::cout << "+---------------------" << "+-----------" << "+-------------" << "+-------------+" << std::endl;
+	}
+}
+
+// AggregateStage constructor
+AggregateStage::AggregateStage(MetricStore *s)
+	:store(s),
+	running(std::make_shared<std::unordered_map<std::string, Aggregates>>()),
+	aggregates_mutex(std::make_shared<std::mutex>())
+{}
+
+// Folds the sample into the running aggregates of its metric
+bool AggregateStage::operator()(Sample &sample)
+{
+	std::unique_lock<std::mutex> lock(*aggregates_mutex);
+
+	auto search = running->find(sample.metric);
+	if (search == running->end())
+	{
+		// Continue from the aggregates of previous runs
+		Aggregates initial;
+		if (!store->get_aggregates(sample.metric, initial))
+			initial = Aggregates();
+		search = running->insert(std::make_pair(sample.metric, initial)).first;
+	}
+
+	Aggregates &agg = search->second;
+	if (!agg.count)
+	{
+		agg.min = sample.value;
+		agg.max = sample.value;
+	}
+	agg.count++;
+	agg.sum += sample.value;
+	agg.min = std::min(agg.min, sample.value);
+	agg.max = std::max(agg.max, sample.value);
+
+	sample.aggregates = agg;
+	return true;
+}
+
+// PersistStage constructor
+PersistStage::PersistStage(MetricStore *s)
+	:store(s)
+{}
+
+// Writes the sample and its aggregates to the store
+bool PersistStage::operator()(Sample &sample)
+{
+	return store->insert_sample(sample.metric, sample.time, sample.value, sample.aggregates) != 0;
+}
@@ -0,0 +1,222 @@
+/**
+  C++ Multithreaded Periodic Task Scheduler
+
+  Pipeline.h
+
+  Purpose:
+  Header file for Sample, Pipeline and the standard metric pipeline stages
+
+  A pipeline is a small DAG of stages such as collect, transform, aggregate
+  and persist. Samples can be submitted to any stage, so every periodic job
+  can enter the DAG through its own stages (its collector, say) and share
+  the stages after them with other jobs. Every stage runs on its own
+  threads and reads its samples from a bounded queue, so different samples
+  can be in different stages at once. A stage that falls behind fills its
+  queue, which blocks the stages feeding it, until the queue of the stage a
+  job submits to is full and its new samples are rejected instead of tying
+  up scheduler workers.
+
+  @version 1.0 10/18/2026
+*/
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <unordered_map>
+#include <boost\thread.hpp>
+#include "BoundedQueue.h"
+#include "MetricStore.h"
+
+/**
+	Sample Structure, the unit of work flowing through a pipeline
+
+	@member metric Metric name
+	@member value Sample value
+	@member time Time the sample was taken
+	@member aggregates Aggregates of the metric including this sample
+*/
+struct Sample
+{
+	std::string metric;
+	double value = 0;
+	std::chrono::system_clock::time_point time;
+	Aggregates aggregates;
+
+	// Default sample constructor
+	Sample()
+	{}
+
+	/**
+	  Sample Constructor
+
+	  @param m Metric name
+	*/
+	Sample(const std::string &m)
+		:metric(m)
+	{}
+};
+
+// Block of code a stage runs for each sample, returns false to drop the sample
+typedef boost::function<bool(Sample &)> StageFunc;
+
+/**
+	Pipeline
+
+	@member stages Stages in the order they were added
+	@member queue_capacity Capacity of the input queue of each stage
+	@member running Bool value set while the stage threads are running
+*/
+class Pipeline
+{
+private:
+	/**
+		Stage Structure
+
+		@member name Stage name
+		@member func Block of code the stage runs for each sample
+		@member thread_count Number of threads executing the stage
+		@member input Queue of samples waiting for the stage
+		@member next Indices of the stages the output is passed to
+		@member threads Threads executing the stage
+		@member processed Number of samples the stage has run on
+		@member rejected Number of samples rejected because the input queue was full
+	*/
+	struct Stage
+	{
+		std::string name;
+		StageFunc func;
+		unsigned thread_count;
+		BoundedQueue<Sample> input;
+		std::vector<std::size_t> next;
+		boost::thread_group threads;
+		std::atomic<std::uint64_t> processed{ 0 };
+		std::atomic<std::uint64_t> rejected{ 0 };
+
+		Stage(const std::string &n, StageFunc f, unsigned t, std::size_t capacity)
+			:name(n),
+			func(f),
+			thread_count(t),
+			input(capacity)
+		{}
+	};
+
+	std::vector<std::unique_ptr<Stage>> stages;
+	std::size_t queue_capacity;
+	bool running = false;
+
+	/**
+	  Function that executes a stage in a loop until its input queue is closed
+
+	  @param index Stage index
+	*/
+	void execute_stage(std::size_t index);
+
+public:
+	/**
+	  Pipeline Constructor
+
+	  @param capacity Capacity of the input queue of each stage
+	*/
+	Pipeline(std::size_t capacity);
+
+	// Stops the pipeline
+	~Pipeline();
+
+	/**
+	  Adds a stage
+
+	  @param name Stage name
+	  @param func Block of code the stage runs for each sample
+	  @param threads Number of threads executing the stage
+	  @return Stage index
+	*/
+	std::size_t add_stage(const std::string &name, StageFunc func, unsigned threads = 1);
+
+	/**
+	  Passes the output of a stage to a later stage. A stage connected to
+	  several stages passes each of them a copy of the sample.
+
+	  @param from Index of the producing stage
+	  @param to Index of the consuming stage, must be added after from
+	  @return returns 1 if successfull else 0
+	*/
+	int connect(std::size_t from, std::size_t to);
+
+	/**
+	  Starts the threads of all stages
+	*/
+	void start();
+
+	/**
+	  Stops accepting samples, lets every stage finish the samples it has
+	  queued and joins the stage threads
+	*/
+	void stop();
+
+	/**
+	  Submits a sample to a stage without waiting
+
+	  @param stage Index of the stage the sample enters the pipeline at
+	  @param sample Sample to submit
+	  @return false if the stage's queue is full, the stage does not exist or the pipeline is stopped
+	*/
+	bool submit(std::size_t stage, const Sample &sample);
+
+	/**
+	  Displays queue depth, processed and rejected samples of each stage
+	*/
+	void get_stages_overview();
+};
+
+/**
+	AggregateStage
+
+	Stage keeping running aggregates of each metric, starting from the
+	aggregates already in the store. Copies share the same aggregates.
+
+	@member store Metric store the initial aggregates are read from
+	@member running Running aggregates by metric name
+	@member aggregates_mutex Mutex to lock while updating the running aggregates
+*/
+class AggregateStage
+{
+private:
+	MetricStore *store;
+	std::shared_ptr<std::unordered_map<std::string, Aggregates>> running;
+	std::shared_ptr<std::mutex> aggregates_mutex;
+
+public:
+	/**
+	  AggregateStage Constructor
+
+	  @param s Metric store the initial aggregates are read from
+	*/
+	AggregateStage(MetricStore *s);
+
+	bool operator()(Sample &sample);
+};
+
+/**
+	PersistStage
+
+	Stage writing the sample and its aggregates to a metric store
+
+	@member store Metric store the sample is written to
+*/
+class PersistStage
+{
+private:
+	MetricStore *store;
+
+public:
+	/**
+	  PersistStage Constructor
+
+	  @param s Metric store the sample is written to
+	*/
+	PersistStage(MetricStore *s);
+
+	bool operator()(Sample &sample);
+};
@@ -13,63 +13,203 @@
 #include <Windows.h>
 #include <Psapi.h>
 #include "task_sqlite.h"
+#include "ConnectionManager.h"
+#include "MetricStore.h"
+#include "ColumnarStore.h"
 #include "PeriodicScheduler.h"
+#include "ControlServer.h"
+#include "Pipeline.h"
+#include "Clock.h"
 #include <boost\thread.hpp>
 
 #define DBFILE "taskscheduler.db"
 
+// Unix domain socket tasks can be managed through, see ControlServer.h for the protocol
+#define CONTROL_SOCKET "taskscheduler.sock"
+
+// Loopback TCP port serving the control protocol where Unix domain sockets are not available
+#define CONTROL_PORT 5170
+
+// Directory of the segment files when built with USE_COLUMNAR_STORE defined
+#define SEGMENT_DIR "segments"
+
+// Placement of the scheduler workers on CPUs, see Affinity.h
+#define WORKER_AFFINITY AFFINITY_NONE
+
+// Samples each pipeline stage can have queued before it holds back the stages feeding it
+#define PIPELINE_QUEUE 64
+
 /**
-  Task that returns the physical memory used by the process
+  Collect stage of the physical memory usage tasks, returns the physical memory used by the process
 
-  @param db Sqlite database connection pointer
+  @param sample Sample the output is written to
+  @return true
 */
-void physical_memory_usage(sqlite3 *db)
+bool physical_memory_usage(Sample &sample)
 {	
+	sample.time = std::chrono::system_clock::now();
 	PROCESS_MEMORY_COUNTERS_EX pmc_ex;
 	GetProcessMemoryInfo(GetCurrentProcess(), (PROCESS_MEMORY_COUNTERS*)&pmc_ex, sizeof(pmc_ex));
-	long physical_mem_usage = (long)pmc_ex.PrivateUsage;
-	
-	// Inserts the value into sqlite database
-	insert_into_table(DBFILE, db, physical_mem_usage, "PHYSICAL_MEM");
+	sample.value = (double)pmc_ex.PrivateUsage;
+	return true;
 }
 
 /**
-  Task that returns the virtual memory used by the process
+  Collect stage of the virtual memory usage tasks, returns the virtual memory used by the process
 
-  @param db Sqlite database connection pointer
+  @param sample Sample the output is written to
+  @return true
 */
-void virtual_memory_usage(sqlite3 *db)
+bool virtual_memory_usage(Sample &sample)
 {
+	sample.time = std::chrono::system_clock::now();
 	MEMORYSTATUSEX memInfo;
 	memInfo.dwLength = sizeof(MEMORYSTATUSEX);
 	GlobalMemoryStatusEx(&memInfo);
-	long virtual_mem_used = (long)(memInfo.ullTotalPageFile - memInfo.ullAvailPageFile);
-	
-	// Inserts the value into sqlite database
-	insert_into_table(DBFILE, db, fabs(virtual_mem_used), "VIRTUAL_MEM");
+	sample.value = (double)(memInfo.ullTotalPageFile - memInfo.ullAvailPageFile);
+	return true;
+}
+
+/**
+  Transform stage, memory usage is stored as an absolute value
+
+  @param sample Collected sample
+  @return true
+*/
+bool absolute_value(Sample &sample)
+{
+	sample.value = fabs(sample.value);
+	return true;
 }
 
-int main()
+/**
+  Displays the aggregates of all metrics, read from one snapshot so that
+  sampling tasks keep writing while the report is generated
+
+  @param store Metric store to query
+*/
+void display_aggregates(MetricStore *store)
+{
+	std::vector<std::string> metrics = { "PHYSICAL_MEM", "VIRTUAL_MEM" };
+	std::vector<Aggregates> aggs;
+
+	if (!store->snapshot_aggregates(metrics, aggs))
+	{
+		std::cout << "Unable to read aggregates!" << std::endl;
+		return;
+	}
+	for (std::size_t i = 0; i < metrics.size(); i++)
+	{
+		std::cout << metrics[i] << ": count " << aggs[i].count << ", avg " << aggs[i].avg()
+			<< ", min " << aggs[i].min << ", max " << aggs[i].max << std::endl;
+	}
+}
+
+/**
+  Runs a synthetic schedule in simulated time and reports how long it took,
+  for capacity planning and regression benchmarking
+
+  @param tasks Number of tasks to schedule
+  @param hours Simulated hours to run the schedule for
+*/
+void simulate_schedule(int tasks, int hours)
 {
+	auto start = std::chrono::system_clock::now();
+	SimulatedClock sim(start);
+
+	// A single worker runs the tasks in deadline and queue order, so the checksum is reproducible
+	PeriodicScheduler scheduler(sim, 1, 1);
+	std::uint64_t checksum = 0;
+
+	// Intervals between 1 second and 5 minutes, staggered so that deadlines are spread out
+	for (int i = 0; i < tasks; i++)
+	{
+		std::uint32_t uid = scheduler.getUid();
+		scheduler.schedule_periodic(uid, "SIMULATED", [&checksum, uid] { checksum = checksum * 31 + uid; },
+			start + std::chrono::milliseconds(i % 1000), 1 + i % 300);
+	}
+
+	auto wall_start = std::chrono::steady_clock::now();
+	std::uint64_t executed = scheduler.run_simulation(sim, start + std::chrono::hours(hours));
+	auto wall = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - wall_start);
+
+	std::cout << "Simulated " << hours << " hours of " << tasks << " tasks: " << executed << " executions in "
+		<< wall.count() << " ms (order checksum " << checksum << ")" << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+	// taskscheduler --simulate <tasks> <hours> runs a synthetic schedule in simulated time and exits
+	if (argc == 4 && std::string(argv[1]) == "--simulate")
+	{
+		simulate_schedule(atoi(argv[2]), atoi(argv[3]));
+		return 0;
+	}
+
+	// taskscheduler --verify-store <directory> checks the columnar segment codec and exits
+	if (argc == 3 && std::string(argv[1]) == "--verify-store")
+	{
+		int ok = verify_columnar_store(argv[2]);
+		std::cout << "Columnar store check " << (ok ? "passed" : "failed") << std::endl;
+		return ok ? 0 : 1;
+	}
+
 	sqlite3 *mainDB = NULL;
 	initialize_database(DBFILE, mainDB);													//Initialize Database
-	sqlite3_open_v2(DBFILE, &mainDB, SQLITE_OPEN_READWRITE | SQLITE_OPEN_FULLMUTEX, NULL);	// Open DB connection
+
+	ConnectionManager connections(DBFILE);
+	if (!connections.open())																// Open writer connection in WAL mode
+	{
+		fprintf(stderr, "Fatal: Unable to open database!\n");
+		return 1;
+	}
+
+#ifdef USE_COLUMNAR_STORE
+	ColumnarMetricStore metricStore(SEGMENT_DIR);
+#else
+	SqliteMetricStore metricStore(DBFILE, connections);
+#endif
+	MetricStore *store = &metricStore;
+
+	// Periodic tasks only submit a sample to their own collect stage, collecting and storing
+	// it happens in the pipeline stages. Stages can only feed stages added after them.
+	Pipeline pipeline(PIPELINE_QUEUE);
+	std::size_t collect_physical = pipeline.add_stage("collect physical", physical_memory_usage);
+	std::size_t collect_virtual = pipeline.add_stage("collect virtual", virtual_memory_usage);
+	std::size_t transform = pipeline.add_stage("transform", absolute_value);
+	std::size_t aggregate = pipeline.add_stage("aggregate", AggregateStage(store));
+	std::size_t persist = pipeline.add_stage("persist", PersistStage(store));
+	pipeline.connect(collect_physical, transform);
+	pipeline.connect(collect_virtual, transform);
+	pipeline.connect(transform, aggregate);
+	pipeline.connect(aggregate, persist);
+	pipeline.start();
+
+	boost::function<void()> physical_memory_task = boost::bind(&Pipeline::submit, &pipeline, collect_physical, Sample("PHYSICAL_MEM"));
+	boost::function<void()> virtual_memory_task = boost::bind(&Pipeline::submit, &pipeline, collect_virtual, Sample("VIRTUAL_MEM"));
 
 	PeriodicScheduler scheduler;
+	scheduler.set_affinity(WORKER_AFFINITY);
 
 	// Schedule tasks initially
-	scheduler.schedule_periodic(scheduler.getUid(), "VIRTUAL MEM USAGE", boost::bind(virtual_memory_usage, mainDB), std::chrono::system_clock::now(), 5);
-	scheduler.schedule_periodic(scheduler.getUid(), "PHY MEM USAGE", boost::bind(physical_memory_usage, mainDB), std::chrono::system_clock::now(), 10);
-	scheduler.schedule_periodic(scheduler.getUid(), "VIRTUAL MEM USAGE", boost::bind(virtual_memory_usage, mainDB), std::chrono::system_clock::now(), 7);
-	scheduler.schedule_periodic(scheduler.getUid(), "PHY MEM USAGE", boost::bind(physical_memory_usage, mainDB), std::chrono::system_clock::now(), 15);
-	scheduler.schedule_periodic(scheduler.getUid(), "VIRTUAL MEM USAGE", boost::bind(virtual_memory_usage, mainDB), std::chrono::system_clock::now(), 3);
-	scheduler.schedule_periodic(scheduler.getUid(), "PHY MEM USAGE", boost::bind(physical_memory_usage, mainDB), std::chrono::system_clock::now(), 5);
-	scheduler.schedule_periodic(scheduler.getUid(), "VIRTUAL MEM USAGE", boost::bind(virtual_memory_usage, mainDB), std::chrono::system_clock::now(), 10);
-	scheduler.schedule_periodic(scheduler.getUid(), "PHY MEM USAGE", boost::bind(physical_memory_usage, mainDB), std::chrono::system_clock::now(), 4);
+	scheduler.schedule_periodic(scheduler.getUid(), "VIRTUAL MEM USAGE", virtual_memory_task, std::chrono::system_clock::now(), 5);
+	scheduler.schedule_periodic(scheduler.getUid(), "PHY MEM USAGE", physical_memory_task, std::chrono::system_clock::now(), 10);
+	scheduler.schedule_periodic(scheduler.getUid(), "VIRTUAL MEM USAGE", virtual_memory_task, std::chrono::system_clock::now(), 7);
+	scheduler.schedule_periodic(scheduler.getUid(), "PHY MEM USAGE", physical_memory_task, std::chrono::system_clock::now(), 15);
+	scheduler.schedule_periodic(scheduler.getUid(), "VIRTUAL MEM USAGE", virtual_memory_task, std::chrono::system_clock::now(), 3);
+	scheduler.schedule_periodic(scheduler.getUid(), "PHY MEM USAGE", physical_memory_task, std::chrono::system_clock::now(), 5);
+	scheduler.schedule_periodic(scheduler.getUid(), "VIRTUAL MEM USAGE", virtual_memory_task, std::chrono::system_clock::now(), 10);
+	scheduler.schedule_periodic(scheduler.getUid(), "PHY MEM USAGE", physical_memory_task, std::chrono::system_clock::now(), 4);
 
 	// Run the scheduler in a new thread
 	boost::thread th(&PeriodicScheduler::run, &scheduler);
 
+	// Serve the control socket with the same task types as the menu
+	ControlServer control(scheduler, CONTROL_SOCKET, CONTROL_PORT);
+	control.register_task_type(1, "PHY MEM USAGE", physical_memory_task);
+	control.register_task_type(2, "VIRTUAL MEM USAGE", virtual_memory_task);
+	control.start();
+
 	std::uint32_t taskid;
 	int interval = 5;
 
@@ -85,9 +225,12 @@ int main()
 		std::cout << "3) Update Task Interval " << std::endl;					// Option to update an existing task
 		std::cout << "4) Delete Task" << std::endl;								// Option to delete task
 		std::cout << "5) Exit Program " << std::endl;							// Option to exit the program
+		std::cout << "6) Display Aggregates " << std::endl;						// Option to view metric aggregates
+		std::cout << "7) Display Scheduler Stats " << std::endl;				// Option to view worker pool statistics
 		
 		std::cout << "Please select an option : ";
-		std::cin >> option;
+		if (!(std::cin >> option))												// Exit once stdin is closed
+			option = 5;
 
 		switch (option)
 		{
@@ -109,7 +252,7 @@ int main()
 				try {
 					scheduler.schedule_periodic(scheduler.getUid(),				// Schedule task type 1
 						"PHY MEM USAGE",
-						boost::bind(physical_memory_usage, mainDB),
+						physical_memory_task,
 						std::chrono::system_clock::now(), interval);
 				}
 				catch (std::exception const &e) {
@@ -121,7 +264,7 @@ int main()
 				try {
 					scheduler.schedule_periodic(scheduler.getUid(),				// Schedule task type 2
 						"VIRTUAL MEM USAGE",
-						boost::bind(virtual_memory_usage, mainDB),
+						virtual_memory_task,
 						std::chrono::system_clock::now(), interval);
 				}
 				catch (std::exception const &e)
@@ -140,7 +283,8 @@ int main()
 			scheduler.get_tasks_overview();										// Displays task list before prompting for task id
 			std::cout << "Enter Task UID and new Interval separated by spaces to update ";
 			std::cin >> taskid >> interval;										// Prompt user for new task interval
-			scheduler.update_task(taskid, interval);							// Add task to update set
+			if (!scheduler.update_task(taskid, interval))						// Add task to update set
+				std::cout << "No task with UID " << taskid << "!" << std::endl;
 			break;
 
 		case 4:
@@ -148,13 +292,24 @@ int main()
 			scheduler.get_tasks_overview();										// Displays task list before prompting for task id
 			std::cout << "Enter Task UID to delete ";							
 			std::cin >> taskid;													// Prompt user for task ID
-			scheduler.delete_task(taskid);										// Add task to delete set
+			if (!scheduler.delete_task(taskid))									// Add task to delete set
+				std::cout << "No task with UID " << taskid << "!" << std::endl;
 			break;
 
 		case 5:
+			control.stop();														// Stop serving the control socket
 			scheduler.stop();													// Stop the scheduler
 			break;
 
+		case 6:
+			display_aggregates(store);
+			break;
+
+		case 7:
+			scheduler.get_stats_overview();
+			pipeline.get_stages_overview();
+			break;
+
 		default:
 			std::cout << "Incorrect option entered!" << std::endl;
 		}
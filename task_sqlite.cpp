@@ -138,14 +138,26 @@ int createDB(char *DBfile, sqlite3 *mainDB)
 }
 
 // Function to insert task output in the database
-int insert_into_table(char *DBfile, sqlite3 *DB, long usage, char *table)
+int insert_into_table(char *DBfile, sqlite3 *DB, double usage, char *table)
+{
+	if (!insert_value(DBfile, DB, usage, table))
+		return(0);
+
+	// Call get_aggregates to get the new aggregated data after insert
+	get_aggregates(DBfile, DB, table);
+
+	return(1);
+}
+
+// Function to insert task output in the database without updating the aggregates
+int insert_value(char *DBfile, sqlite3 *DB, double usage, char *table)
 {
 
 	int rc;
 	sqlite3_stmt *stmt;
 
-	// Insert values in Database table according to task
-	std::string x = "INSERT INTO " + std::string(table) + " (Val) VALUES (" + std::to_string(usage) + ")";
+	// Insert values in Database table according to task, the value is bound as a double so it is stored unrounded
+	std::string x = "INSERT INTO " + std::string(table) + " (Val) VALUES (?)";
 
 	const char *sql_str = x.c_str();
 
@@ -156,18 +168,16 @@ int insert_into_table(char *DBfile, sqlite3 *DB, long usage, char *table)
 	}
 	else
 	{
+		sqlite3_bind_double(stmt, 1, usage);
 		rc = sqlite3_step(stmt);
 		if (rc != SQLITE_DONE)
 		{
 			fprintf(stderr, "Insert Step error (%d): %s", rc, sqlite3_errmsg(DB));
+			sqlite3_finalize(stmt);
 			return(0);
 		}
 	}
 	sqlite3_finalize(stmt);
-
-	// Call get_aggregates to get the new aggregated data after insert
-	get_aggregates(DBfile, DB, table);
-
 	return(1);
 }
 
@@ -256,4 +266,18 @@ int insert_aggregates(char *DBfile, sqlite3 *DB, std::string avg, std::string mi
 	}
 	sqlite3_finalize(stmt);
 	return 1;
-}
\ No newline at end of file
+}
+
+// Function to execute a statement which returns no rows
+int execute_statement(sqlite3 *DB, const char *sql)
+{
+	char *err = NULL;
+
+	if (SQLITE_OK != sqlite3_exec(DB, sql, NULL, NULL, &err))
+	{
+		fprintf(stderr, "Exec error (%s): %s\n", sql, err ? err : sqlite3_errmsg(DB));
+		sqlite3_free(err);
+		return 0;
+	}
+	return 1;
+}
@@ -40,7 +40,18 @@ int createDB(char *DBfile, sqlite3 *mainDB);
   @param table Task specific table to insert output in DB
   @return returns 1 if successfull else 0
 */
-int insert_into_table(char *DBfile, sqlite3 *mainDB, long usage, char *table);
+int insert_into_table(char *DBfile, sqlite3 *mainDB, double usage, char *table);
+
+/**
+  Function to insert task output in the database without updating the aggregates
+
+  @param DBfile Database File pointer
+  @param DB Sqlite Database connection pointer
+  @param usage Task output data
+  @param table Task specific table to insert output in DB
+  @return returns 1 if successfull else 0
+*/
+int insert_value(char *DBfile, sqlite3 *DB, double usage, char *table);
 
 /**
   Function to get aggregated data from the the task output table 
@@ -61,4 +72,13 @@ void get_aggregates(char *DBfile, sqlite3 *DB, char *task);
   @param max Maximum aggregate value
   @return returns 1 if successfull else 0
 */
-int insert_aggregates(char *DBfile, sqlite3 *DB, std::string avg, std::string min, std::string max, char *task);
\ No newline at end of file
+int insert_aggregates(char *DBfile, sqlite3 *DB, std::string avg, std::string min, std::string max, char *task);
+
+/**
+  Function to execute a statement which returns no rows, such as BEGIN or a PRAGMA
+
+  @param DB Sqlite Database connection pointer
+  @param sql Statement to execute
+  @return returns 1 if successfull else 0
+*/
+int execute_statement(sqlite3 *DB, const char *sql);